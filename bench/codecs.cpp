@@ -0,0 +1,90 @@
+// Степень сжатия и скорость всех алгоритмов на корпусе из bench/corpus.
+// Запуск: make bench-codecs или bin/bench_codecs [каталог корпуса] [повторов]
+#include "Compression.hpp"
+#include "FileContent.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Algo {
+    const char* name;
+    CompAlgo algo;
+};
+
+constexpr Algo kAlgos[] = {
+    {"all", CompAlgo::LZW_VAR_ALL},
+    {"alpha", CompAlgo::LZW_VAR_ALPHA},
+    {"fast", CompAlgo::LZ_FAST},
+    {"best", CompAlgo::LZ_HUFF},
+};
+
+std::vector<std::uint8_t> readHostFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+double seconds(std::chrono::steady_clock::time_point from) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - from).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::filesystem::path dir = argc > 1 ? argv[1] : "bench/corpus";
+    const int reps = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+    std::vector<std::filesystem::path> files;
+    for (const auto& e : std::filesystem::directory_iterator(dir)) {
+        if (e.is_regular_file()) files.push_back(e.path());
+    }
+    std::sort(files.begin(), files.end());
+    if (files.empty()) {
+        std::cerr << "no corpus files in " << dir << "\n";
+        return 1;
+    }
+
+    // Один поток: сравниваются кодеки, а не масштабирование.
+    std::cout << std::left << std::setw(16) << "file" << std::setw(7) << "algo" << std::right
+              << std::setw(10) << "bytes" << std::setw(10) << "packed" << std::setw(8) << "ratio"
+              << std::setw(14) << "compress MB/s" << std::setw(16) << "decompress MB/s" << "\n";
+    for (const auto& path : files) {
+        const auto data = readHostFile(path);
+        FileContent source;
+        source.replaceAll(data);
+        const double mb = static_cast<double>(data.size()) / (1024 * 1024);
+        for (const auto& a : kAlgos) {
+            double comp = 1e30, decomp = 1e30;
+            std::size_t packed = 0;
+            for (int r = 0; r < reps; ++r) {
+                FileContent f = source;
+                auto start = std::chrono::steady_clock::now();
+                compressInplace(f, a.algo, 1);
+                comp = std::min(comp, seconds(start));
+                packed = f.size();
+                start = std::chrono::steady_clock::now();
+                uncompressInplace(f, 1);
+                decomp = std::min(decomp, seconds(start));
+                if (f.size() != data.size()) {
+                    std::cerr << "roundtrip mismatch: " << path << " " << a.name << "\n";
+                    return 1;
+                }
+            }
+            std::cout << std::left << std::setw(16) << path.filename().string() << std::setw(7) << a.name
+                      << std::right << std::setw(10) << data.size() << std::setw(10) << packed
+                      << std::setw(8) << std::fixed << std::setprecision(3)
+                      << static_cast<double>(packed) / static_cast<double>(data.size())
+                      << std::setw(14) << std::setprecision(1) << mb / comp
+                      << std::setw(16) << mb / decomp << "\n";
+        }
+    }
+}
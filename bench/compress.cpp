@@ -0,0 +1,317 @@
+// Все алгоритмы CompAlgo на корпусе из текста, JSON, двоичных записей и случайных
+// байт нескольких размеров: степень сжатия, скорость сжатия и распаковки, пик
+// памяти кучи. Результат — таблица в stdout и тот же набор строк в JSON.
+// Корпус генерируется детерминированно (фиксированные seed), поэтому цифры
+// разных версий кодеков сравнимы между собой.
+// Запуск: make bench-compress [BENCH_COMPRESS_MB=64] или
+//         bin/bench_compress [макс. МиБ] [файл JSON] [повторов]
+#include "Compression.hpp"
+#include "DictTrainer.hpp"
+#include "FileContent.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <malloc.h>
+#include <new>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+// ---- Учёт кучи: пик занятых байт с момента resetPeak ----
+
+namespace {
+
+std::atomic<std::size_t> gHeapNow{0};
+std::atomic<std::size_t> gHeapPeak{0};
+
+void* countedAlloc(std::size_t n) {
+    void* p = std::malloc(n ? n : 1);
+    if (!p) return nullptr;
+    const std::size_t now = gHeapNow.fetch_add(malloc_usable_size(p)) + malloc_usable_size(p);
+    std::size_t peak = gHeapPeak.load();
+    while (now > peak && !gHeapPeak.compare_exchange_weak(peak, now)) {}
+    return p;
+}
+
+void countedFree(void* p) noexcept {
+    if (!p) return;
+    gHeapNow.fetch_sub(malloc_usable_size(p));
+    std::free(p);
+}
+
+} // namespace
+
+void* operator new(std::size_t n) {
+    if (void* p = countedAlloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) {
+    if (void* p = countedAlloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept { return countedAlloc(n); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept { return countedAlloc(n); }
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { countedFree(p); }
+
+namespace {
+
+// Пик относительно занятого на момент вызова.
+std::size_t resetPeak() {
+    const std::size_t now = gHeapNow.load();
+    gHeapPeak.store(now);
+    return now;
+}
+
+std::size_t peakSince(std::size_t base) {
+    return gHeapPeak.load() - std::min(base, gHeapPeak.load());
+}
+
+// ---- Корпус ----
+
+using Bytes = std::vector<std::uint8_t>;
+
+// Словарь псевдослов с частотами примерно по Ципфу.
+class Words {
+public:
+    Words(std::mt19937& rng, std::size_t count) : rng_(rng) {
+        static const char* kSyllables[] = {"ka", "to", "re", "mi", "sa", "lo", "ne", "di", "ver", "con",
+                                           "pre", "tion", "al", "er", "in", "st", "ou", "ght", "ing", "ed"};
+        for (std::size_t i = 0; i < count; ++i) {
+            std::string w;
+            for (std::size_t s = 1 + rng() % 3; s > 0; --s) w += kSyllables[rng() % std::size(kSyllables)];
+            words_.push_back(std::move(w));
+        }
+    }
+    const std::string& next() {
+        const double u = static_cast<double>(rng_()) / rng_.max();
+        const auto idx = static_cast<std::size_t>(words_.size() * std::pow(u, 3.0));
+        return words_[std::min(idx, words_.size() - 1)];
+    }
+
+private:
+    std::mt19937& rng_;
+    std::vector<std::string> words_;
+};
+
+Bytes makeText(std::size_t bytes, std::uint32_t seed) {
+    std::mt19937 rng(seed);
+    Words words(rng, 5000);
+    Bytes out;
+    out.reserve(bytes + 64);
+    while (out.size() < bytes) {
+        for (std::size_t n = 6 + rng() % 10; n > 0; --n) {
+            const auto& w = words.next();
+            out.insert(out.end(), w.begin(), w.end());
+            out.push_back(n == 1 ? '.' : ' ');
+        }
+        out.push_back(rng() % 4 == 0 ? '\n' : ' ');
+    }
+    out.resize(bytes);
+    return out;
+}
+
+Bytes makeJson(std::size_t bytes, std::uint32_t seed) {
+    static const char* kEvents[] = {"login", "logout", "page_view", "purchase", "search", "error"};
+    static const char* kRegions[] = {"eu-west-1", "us-east-1", "ap-south-1", "sa-east-1"};
+    std::mt19937 rng(seed);
+    Words words(rng, 800);
+    Bytes out;
+    out.reserve(bytes + 512);
+    for (std::uint64_t id = 1; out.size() < bytes; ++id) {
+        std::string r = "{\"id\":" + std::to_string(id) + ",\"user\":\"" + words.next() + "_" +
+                        std::to_string(rng() % 10000) + "\",\"event\":\"" + kEvents[rng() % std::size(kEvents)] +
+                        "\",\"ts\":" + std::to_string(1700000000 + id * 7 + rng() % 5) +
+                        ",\"region\":\"" + kRegions[rng() % std::size(kRegions)] +
+                        "\",\"latency_ms\":" + std::to_string(rng() % 2000) +
+                        ",\"tags\":[\"" + words.next() + "\",\"" + words.next() + "\"],\"ok\":" +
+                        (rng() % 10 ? "true" : "false") + "}\n";
+        out.insert(out.end(), r.begin(), r.end());
+    }
+    out.resize(bytes);
+    return out;
+}
+
+// Записи телеметрии фиксированного размера: счётчики, медленно меняющиеся
+// величины, флаги из малого набора — типичные «двоичные» данные.
+Bytes makeBinary(std::size_t bytes, std::uint32_t seed) {
+    std::mt19937 rng(seed);
+    Bytes out;
+    out.reserve(bytes + 32);
+    auto put = [&](std::uint64_t v, int n) {
+        for (int i = 0; i < n; ++i) out.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+    };
+    std::uint32_t ts = 1700000000;
+    float level = 20.0f;
+    for (std::uint32_t id = 0; out.size() < bytes; ++id) {
+        ts += 1 + rng() % 3;
+        level += (static_cast<float>(rng() % 1000) - 500.0f) / 1000.0f;
+        std::uint32_t bits;
+        static_assert(sizeof(bits) == sizeof(level));
+        std::memcpy(&bits, &level, sizeof(bits));
+        put(id, 4);
+        put(ts, 4);
+        put(bits, 4);
+        put(0xCAFE0000u | (rng() % 8), 4);
+        put(rng() % 4 ? 0 : rng(), 8);
+    }
+    out.resize(bytes);
+    return out;
+}
+
+Bytes makeRandom(std::size_t bytes, std::uint32_t seed) {
+    std::mt19937_64 rng(seed);
+    Bytes out(bytes);
+    for (auto& b : out) b = static_cast<std::uint8_t>(rng());
+    return out;
+}
+
+struct Kind {
+    const char* name;
+    Bytes (*make)(std::size_t, std::uint32_t);
+};
+
+constexpr Kind kKinds[] = {
+    {"text", makeText},
+    {"json", makeJson},
+    {"binary", makeBinary},
+    {"random", makeRandom},
+};
+
+struct Algo {
+    const char* name;
+    CompAlgo algo;
+};
+
+// Все значения CompAlgo; dict — со словарём, обученным на другом образце того же вида.
+constexpr Algo kAlgos[] = {
+    {"all", CompAlgo::LZW_VAR_ALL},
+    {"alpha", CompAlgo::LZW_VAR_ALPHA},
+    {"fast", CompAlgo::LZ_FAST},
+    {"best", CompAlgo::LZ_HUFF},
+    {"wide", CompAlgo::LZW_WIDE},
+    {"stored", CompAlgo::STORED},
+    {"dict", CompAlgo::LZ_DICT},
+    {"auto", CompAlgo::AUTO},
+};
+
+struct Row {
+    std::string kind;
+    std::size_t bytes;
+    std::string algo;
+    std::size_t packed;
+    double compressMBps;
+    double decompressMBps;
+    std::size_t peakCompress;
+    std::size_t peakDecompress;
+};
+
+double seconds(std::chrono::steady_clock::time_point from) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - from).count();
+}
+
+std::string sizeLabel(std::size_t bytes) {
+    if (bytes >= 1024 * 1024) return std::to_string(bytes / (1024 * 1024)) + "M";
+    return std::to_string(bytes / 1024) + "K";
+}
+
+void writeJson(const std::string& path, const std::vector<Row>& rows) {
+    std::ofstream out(path);
+    out << "[\n";
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        const auto& r = rows[i];
+        out << "  {\"kind\": \"" << r.kind << "\", \"bytes\": " << r.bytes << ", \"algo\": \"" << r.algo
+            << "\", \"packed\": " << r.packed << std::fixed << std::setprecision(4)
+            << ", \"ratio\": " << static_cast<double>(r.packed) / static_cast<double>(r.bytes)
+            << std::setprecision(2) << ", \"compress_mbps\": " << r.compressMBps
+            << ", \"decompress_mbps\": " << r.decompressMBps
+            << ", \"peak_compress_bytes\": " << r.peakCompress
+            << ", \"peak_decompress_bytes\": " << r.peakDecompress << "}"
+            << (i + 1 < rows.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t maxMb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8;
+    const std::string jsonPath = argc > 2 ? argv[2] : "bin/bench_compress.json";
+    const int reps = argc > 3 ? std::max(1, std::atoi(argv[3])) : 3;
+
+    std::vector<std::size_t> sizes{4 * 1024, 64 * 1024, 1024 * 1024};
+    for (std::size_t mb = 8; mb <= maxMb; mb *= 8) sizes.push_back(mb * 1024 * 1024);
+    sizes.erase(std::remove_if(sizes.begin(), sizes.end(),
+                               [&](std::size_t s) { return s > std::max<std::size_t>(1, maxMb) * 1024 * 1024; }),
+                sizes.end());
+
+    // Один поток: сравниваются кодеки, а не масштабирование (его меряет bench-threads).
+    std::cout << std::left << std::setw(8) << "kind" << std::setw(6) << "size" << std::setw(8) << "algo"
+              << std::right << std::setw(8) << "ratio" << std::setw(10) << "comp MB/s" << std::setw(12)
+              << "decomp MB/s" << std::setw(13) << "peak comp KB" << std::setw(15) << "peak decomp KB" << "\n";
+    std::vector<Row> rows;
+    for (const auto& kind : kKinds) {
+        // словарь учится на мелких кусках другого образца: так его используют в VFS
+        const Bytes training = kind.make(1024 * 1024, 1);
+        std::vector<std::span<const std::uint8_t>> samples;
+        for (std::size_t off = 0; off + 1024 <= training.size(); off += 1024) {
+            samples.emplace_back(training.data() + off, 1024);
+        }
+        const DictionaryPtr dict = makeDictionary(trainDictionary(samples, kMaxDictionary));
+        const DictionaryLookup lookup = [&](std::uint32_t) { return dict; };
+
+        for (std::size_t size : sizes) {
+            const Bytes data = kind.make(size, 2);
+            FileContent source;
+            source.replaceAll(data);
+            const double mb = static_cast<double>(size) / (1024 * 1024);
+            // мелкие входы повторяем чаще, чтобы время не тонуло в шуме таймера
+            const int runs = reps * static_cast<int>(std::clamp<std::size_t>((1024 * 1024) / size, 1, 64));
+            for (const auto& a : kAlgos) {
+                Row row{kind.name, size, a.name, 0, 0, 0, 0, 0};
+                double comp = 1e30, decomp = 1e30;
+                for (int r = 0; r < runs; ++r) {
+                    FileContent f = source;     // разделяет буфер с source — в пик не входит
+                    std::size_t base = resetPeak();
+                    auto start = std::chrono::steady_clock::now();
+                    compressInplace(f, a.algo, 1, {}, dict);
+                    comp = std::min(comp, seconds(start));
+                    row.peakCompress = std::max(row.peakCompress, peakSince(base));
+                    row.packed = f.size();
+
+                    base = resetPeak();
+                    start = std::chrono::steady_clock::now();
+                    uncompressInplace(f, 1, lookup);
+                    decomp = std::min(decomp, seconds(start));
+                    row.peakDecompress = std::max(row.peakDecompress, peakSince(base));
+                    if (f.size() != size || f.bytes() != data) {
+                        std::cerr << "roundtrip mismatch: " << kind.name << " " << size << " " << a.name << "\n";
+                        return 1;
+                    }
+                }
+                row.compressMBps = mb / comp;
+                row.decompressMBps = mb / decomp;
+                std::cout << std::left << std::setw(8) << row.kind << std::setw(6) << sizeLabel(size)
+                          << std::setw(8) << row.algo << std::right << std::fixed << std::setprecision(3)
+                          << std::setw(8) << static_cast<double>(row.packed) / static_cast<double>(size)
+                          << std::setprecision(1) << std::setw(10) << row.compressMBps << std::setw(12)
+                          << row.decompressMBps << std::setw(13) << row.peakCompress / 1024 << std::setw(15)
+                          << row.peakDecompress / 1024 << "\n";
+                rows.push_back(std::move(row));
+            }
+        }
+    }
+    writeJson(jsonPath, rows);
+    std::cout << "json: " << jsonPath << "\n";
+}
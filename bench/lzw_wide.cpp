@@ -0,0 +1,85 @@
+// Степень сжатия LZW в зависимости от размера файла: ALL (16 бит, словарь на блок
+// kCompressBlock) против WIDE (сброс словаря, широкие коды, блок kWideBlock).
+// Словарь корпуса сменяется каждые несколько мегабайт, как в длинных логах.
+// Запуск: make bench-lzw-wide [BENCH_MB=64] или bin/bench_lzw_wide [макс. мегабайт]
+#include "Compression.hpp"
+#include "FileContent.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Текст из слов; каждые 3 МиБ половина словаря заменяется новыми словами.
+std::vector<std::uint8_t> makeDriftingCorpus(std::size_t bytes) {
+    constexpr std::size_t kDrift = 3 * 1024 * 1024;
+    std::mt19937 rng(7);
+    auto newWord = [&] {
+        std::string w;
+        for (std::size_t len = 3 + rng() % 8; w.size() < len; ) w.push_back(static_cast<char>('a' + rng() % 26));
+        return w;
+    };
+    std::vector<std::string> words(4000);
+    for (auto& w : words) w = newWord();
+    std::vector<std::uint8_t> out;
+    out.reserve(bytes);
+    std::size_t nextDrift = kDrift;
+    while (out.size() < bytes) {
+        if (out.size() >= nextDrift) {
+            for (std::size_t i = 0; i < words.size() / 2; ++i) words[rng() % words.size()] = newWord();
+            nextDrift += kDrift;
+        }
+        // частые слова встречаются чаще (примерно по Ципфу)
+        const std::size_t idx = static_cast<std::size_t>(words.size() * std::pow(static_cast<double>(rng()) / rng.max(), 3.0));
+        const auto& w = words[std::min(idx, words.size() - 1)];
+        out.insert(out.end(), w.begin(), w.end());
+        out.push_back(rng() % 12 == 0 ? '\n' : ' ');
+    }
+    out.resize(bytes);
+    return out;
+}
+
+double seconds(std::chrono::steady_clock::time_point from) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - from).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t maxMb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    const auto corpus = makeDriftingCorpus(maxMb * 1024 * 1024);
+
+    std::cout << std::setw(8) << "MiB" << std::setw(10) << "all" << std::setw(10) << "wide"
+              << std::setw(16) << "all comp MB/s" << std::setw(17) << "wide comp MB/s"
+              << std::setw(18) << "wide decomp MB/s" << "\n";
+    for (std::size_t mb = 1; mb <= maxMb; mb *= 2) {
+        FileContent source;
+        source.replaceAll(std::span<const std::uint8_t>(corpus.data(), mb * 1024 * 1024));
+        double ratio[2], comp[2], decomp = 0;
+        const CompAlgo algos[2] = {CompAlgo::LZW_VAR_ALL, CompAlgo::LZW_WIDE};
+        for (int a = 0; a < 2; ++a) {
+            FileContent f = source;
+            auto start = std::chrono::steady_clock::now();
+            compressInplace(f, algos[a], 1);
+            comp[a] = static_cast<double>(mb) / seconds(start);
+            ratio[a] = static_cast<double>(f.size()) / static_cast<double>(source.size());
+            start = std::chrono::steady_clock::now();
+            uncompressInplace(f, 1);
+            if (a == 1) decomp = static_cast<double>(mb) / seconds(start);
+            if (f.size() != source.size()) {
+                std::cerr << "roundtrip mismatch at " << mb << " MiB\n";
+                return 1;
+            }
+        }
+        std::cout << std::setw(8) << mb << std::fixed << std::setprecision(3) << std::setw(10) << ratio[0]
+                  << std::setw(10) << ratio[1] << std::setprecision(1) << std::setw(16) << comp[0]
+                  << std::setw(17) << comp[1] << std::setw(18) << decomp << "\n";
+    }
+}
@@ -0,0 +1,75 @@
+// Скорость блочного сжатия/распаковки в зависимости от числа потоков.
+// Запуск: make bench-threads [BENCH_MB=64] или bin/bench_threads [мегабайты] [макс. потоков]
+#include "Compression.hpp"
+#include "FileContent.hpp"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Текст из случайных слов небольшого словаря: сжимается примерно как логи.
+std::vector<std::uint8_t> makeCorpus(std::size_t bytes) {
+    const char* words[] = {"error", "warning", "request", "user", "timeout", "connection",
+                           "GET", "POST", "/api/v1/items", "200", "404", "latency", "ms"};
+    std::mt19937 rng(1);
+    std::vector<std::uint8_t> out;
+    out.reserve(bytes);
+    while (out.size() < bytes) {
+        const std::string w = words[rng() % std::size(words)];
+        out.insert(out.end(), w.begin(), w.end());
+        out.push_back(rng() % 8 == 0 ? '\n' : ' ');
+    }
+    out.resize(bytes);
+    return out;
+}
+
+double seconds(std::chrono::steady_clock::time_point from) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - from).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    const unsigned maxThreads = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10))
+                                         : ThreadPool::defaultThreads();
+    const auto corpus = makeCorpus(mb * 1024 * 1024);
+    FileContent source;
+    source.replaceAll(corpus);
+
+    std::cout << "corpus " << mb << " MiB, up to " << maxThreads << " threads\n"
+              << std::setw(8) << "threads" << std::setw(14) << "compress MB/s"
+              << std::setw(16) << "decompress MB/s" << std::setw(10) << "speedup\n";
+    std::vector<std::uint8_t> reference;
+    double base = 0;
+    for (unsigned t = 1; t <= maxThreads; t = t < maxThreads && t * 2 > maxThreads ? maxThreads : t * 2) {
+        FileContent f = source;
+        auto start = std::chrono::steady_clock::now();
+        compressInplace(f, CompAlgo::LZW_VAR_ALL, t);
+        const double comp = seconds(start);
+        // результат обязан совпадать побайтно при любом числе потоков
+        auto packed = f.bytes();
+        if (reference.empty()) reference = packed;
+        else if (packed != reference) { std::cerr << "output differs at " << t << " threads\n"; return 1; }
+
+        start = std::chrono::steady_clock::now();
+        uncompressInplace(f, t);
+        const double decomp = seconds(start);
+        if (f.size() != corpus.size()) { std::cerr << "roundtrip failed\n"; return 1; }
+
+        const double mbps = corpus.size() / 1e6 / comp;
+        if (t == 1) base = mbps;
+        std::cout << std::setw(8) << t << std::setw(14) << std::fixed << std::setprecision(1) << mbps
+                  << std::setw(16) << corpus.size() / 1e6 / decomp
+                  << std::setw(9) << std::setprecision(2) << mbps / base << "x\n";
+        if (t == maxThreads) break;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Контентно-адресуемое хранилище: одинаковые буферы хранятся один раз.
+// Счётчик ссылок — это use_count разделяемого буфера; хранилище держит
+// только weak_ptr, поэтому неиспользуемые блобы освобождаются сами.
+class BlobStore {
+public:
+    using Buffer = std::vector<std::uint8_t>;
+    using BufferPtr = std::shared_ptr<Buffer>;
+
+    // Возвращает канонический буфер с тем же содержимым (или сам buf).
+    BufferPtr intern(const BufferPtr& buf);
+
+    static std::uint64_t hashBytes(const std::uint8_t* data, std::size_t n) noexcept;
+
+    // Сколько хэшей в индексе (включая ещё не вычищенные мёртвые).
+    std::size_t bucketCount();
+
+private:
+    // Вычистка мёртвых записей и пустых корзин, когда индекс вырос вдвое с прошлой:
+    // в среднем O(1) на intern, а индекс не больше удвоенного числа живых блобов.
+    static constexpr std::size_t kMinSweep = 1024;
+
+    void sweepLocked();
+
+    std::unordered_map<std::uint64_t, std::vector<std::weak_ptr<Buffer>>> buckets_;
+    std::size_t sweepAt_{kMinSweep};
+    std::mutex mu_;
+};
@@ -1,14 +1,143 @@
 #pragma once
+#include <algorithm>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
 #include <vector>
 
 class FileContent;
+namespace lzw { class Decoder; }
+class BlockCodec;
 
 enum class CompAlgo : std::uint8_t {
+    // Только для запроса: алгоритм выбирается пробным сжатием (chooseAlgo),
+    // в заголовок никогда не пишется
+    AUTO          = 0,
     LZW_VAR_ALL   = 2,
-    LZW_VAR_ALPHA = 3
+    LZW_VAR_ALPHA = 3,
+    // LZ77 в стиле LZ4: хуже сжимает текст, но распаковка во много раз быстрее
+    LZ_FAST       = 4,
+    // LZ77 + канонический Хаффман: лучше LZW по степени сжатия, для архивного хранения
+    LZ_HUFF       = 5,
+    // LZW с кодом сброса словаря и кодами до lzw::kDefaultWideBits бит на крупных
+    // блоках (kWideBlock): словарь не замерзает на длинных файлах с меняющимся содержимым
+    LZW_WIDE      = 6,
+    // Без сжатия: блоки лежат как есть. Для данных, которые не сжимаются
+    STORED        = 7,
+    // LZ_FAST с общим словарём (train-dict): для множества мелких похожих файлов.
+    // В заголовке после полей v4/v5 — id словаря (4 байта)
+    LZ_DICT       = 8
+};
+
+// Контейнер CMP v5: исходные данные режутся на блоки по kCompressBlock байт,
+// каждый сжимается независимо, а заголовок хранит таблицу концов блоков.
+// Блок, который не сжался, хранится как есть (флаг в старшем бите записи таблицы),
+// так что контейнер больше исходных данных разве что на заголовок.
+// Поэтому чтение с произвольной позиции распаковывает один блок, а не всё до неё.
+// Рядом с концом блока лежит CRC32C его исходных байт: распакованный блок
+// сверяется с ней до того, как попадёт к читателю, и при несовпадении — Corrupted.
+// v4 (без контрольных сумм) и монолитный v3 по-прежнему читаются, без проверки.
+constexpr std::size_t kCompressBlock = 256 * 1024;
+// LZW_WIDE: большому словарю нужен длинный блок, иначе он не успевает заполниться.
+// Цена — произвольный доступ распаковывает до блока целиком.
+constexpr std::size_t kWideBlock = 8 * 1024 * 1024;
+
+// Общий словарь: история, с которой начинается каждый блок LZ_DICT. Мелкий файл
+// находит в ней совпадения, которых в нём самом нет.
+struct SharedDictionary {
+    std::uint32_t id{0};
+    std::vector<std::uint8_t> bytes;
+};
+using DictionaryPtr = std::shared_ptr<const SharedDictionary>;
+// Словарь по id из заголовка; nullptr — неизвестен. Может вызываться из разных потоков.
+using DictionaryLookup = std::function<DictionaryPtr(std::uint32_t)>;
+// Дальше словаря совпадения LZ_FAST не дотягиваются (2-байтовое смещение).
+constexpr std::size_t kMaxDictionary = 32 * 1024;
+
+// Id по содержимому (FNV-1a), никогда не 0.
+std::uint32_t dictionaryId(std::span<const std::uint8_t> bytes);
+DictionaryPtr makeDictionary(std::vector<std::uint8_t> bytes);
+
+// Цель выбора для CompAlgo::AUTO. Цена кандидата — доля сжатого размера плюс
+// speedWeight * секунд на МиБ (сжатие и распаковка, оценка по bench-codecs).
+struct AutoObjective {
+    double speedWeight{1.0};    // 0 — только размер; 10 и больше — почти только скорость
+};
+
+// Прозрачное сжатие каталога: файлы поддерева сжимаются при записи и
+// распаковываются при чтении. enabled = false отменяет политику предка.
+struct CompressionPolicy {
+    bool enabled{false};
+    CompAlgo algo{CompAlgo::AUTO};
+    AutoObjective objective;
+    std::uint32_t dictId{0};    // для LZ_DICT (и как кандидат AUTO)
 };
 
 bool isCompressed(const FileContent& f);
-void compressInplace(FileContent& f, CompAlgo algo);
-void uncompressInplace(FileContent& f);
+// Быстрая предпроверка по энтропии байтов начала файла: похоже на уже сжатые
+// данные. Такие файлы compressInplace сохраняет как STORED, не запуская кодек.
+bool looksIncompressible(const FileContent& f);
+// Пробует все кодеки на нескольких кусках файла и возвращает самый дешёвый
+// по objective; STORED — если ни один не окупается. С dict пробуется и LZ_DICT.
+CompAlgo chooseAlgo(const FileContent& f, const AutoObjective& objective = {}, const DictionaryPtr& dict = nullptr);
+// threads — сколько потоков общего пула (ThreadPool::shared) сжимают/распаковывают
+// блоки (0 — по числу ядер, больше ядер не бывает); результат от него не зависит. LZ_DICT требует dict.
+void compressInplace(FileContent& f, CompAlgo algo, unsigned threads = 0, const AutoObjective& objective = {},
+                     const DictionaryPtr& dict = nullptr);
+// dicts нужен только файлам LZ_DICT; неизвестный словарь — NotFound.
+void uncompressInplace(FileContent& f, unsigned threads = 0, const DictionaryLookup& dicts = {});
+// Дописывает data к сжатому файлу, не трогая его полные блоки: заново сжимается
+// только неполный последний блок вместе с data. Если от этого растёт таблица
+// блоков, сжатые байты остальных сдвигаются копированием. false — файл v3/v4
+// (нет контрольных сумм старых блоков), он не изменён.
+bool appendCompressed(FileContent& f, std::span<const std::uint8_t> data, unsigned threads = 0,
+                      const DictionaryLookup& dicts = {});
+
+// Распакованные байты с позиции off в dst; возвращает число скопированных
+// (меньше dst.size() только у конца данных). Распаковываются лишь нужные блоки.
+std::size_t readDecompressed(const FileContent& f, std::uint64_t off, std::span<std::uint8_t> dst,
+                             const DictionaryLookup& dicts = {});
+
+// Потоковое чтение сжатого файла: распаковывает по мере запроса, держа в памяти
+// только словарь и небольшой кусок вывода. Файл не должен меняться, пока жив читатель.
+class DecompressReader {
+public:
+    explicit DecompressReader(const FileContent& f, const DictionaryLookup& dicts = {});
+    ~DecompressReader();
+
+    // Копирует в dst до dst.size() распакованных байт; 0 — конец данных.
+    std::size_t read(std::span<std::uint8_t> dst);
+    std::uint64_t size() const noexcept { return origSize_; }
+    std::uint64_t tell() const noexcept { return produced_ - (pending_.size() - pendingPos_); }
+    // Переход к позиции распакованных данных (за концом — к концу). В v4/v5 начинает
+    // с блока, содержащего pos; в v3 назад можно только распаковкой с начала.
+    void seek(std::uint64_t pos);
+
+private:
+    void refill();
+    void startBlock(std::size_t idx);
+    void skip(std::uint64_t n);
+    std::uint64_t blockEnd(std::size_t idx) const noexcept {
+        return std::min(origSize_, (idx + 1) * blockSize_);
+    }
+
+    const FileContent& file_;
+    // LZW в v3/v4 распаковывается потоково (v3 — один блок на весь файл),
+    // остальное — блоком целиком: в v5 блок не отдаётся, пока не сверена CRC.
+    std::unique_ptr<lzw::Decoder> decoder_;
+    std::unique_ptr<BlockCodec> codec_;
+    std::uint64_t origSize_{0};
+    // v3 — один блок на весь файл
+    std::uint64_t blockSize_{0};
+    std::size_t dataStart_{0};
+    std::vector<std::uint64_t> ends_;   // смещение конца каждого блока в файле
+    std::vector<bool> stored_;          // блок не сжат
+    std::vector<std::uint32_t> crcs_;   // CRC32C блоков; пусто до v5
+    std::size_t block_{0};              // == ends_.size() — все блоки прочитаны
+    std::size_t srcPos_{0};
+    std::size_t srcEnd_{0};
+    std::uint64_t produced_{0};
+    std::vector<std::uint8_t> pending_;
+    std::size_t pendingPos_{0};
+};
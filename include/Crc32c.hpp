@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <span>
+
+// CRC32C (Castagnoli, полином 0x1EDC6F41) — контрольная сумма блоков CMP.
+// На x86-64 с SSE4.2 и на AArch64 с расширением CRC считается инструкцией
+// процессора (выбор при первом вызове), иначе — таблично по 8 байт за шаг.
+
+namespace crc32c {
+
+// Продолжает сумму crc (результат предыдущего вызова, 0 — начало) байтами data.
+std::uint32_t extend(std::uint32_t crc, std::span<const std::uint8_t> data) noexcept;
+inline std::uint32_t compute(std::span<const std::uint8_t> data) noexcept { return extend(0, data); }
+
+// Табличная реализация — для проверки аппаратной.
+std::uint32_t extendSoftware(std::uint32_t crc, std::span<const std::uint8_t> data) noexcept;
+bool hardwareAvailable() noexcept;
+
+} // namespace crc32c
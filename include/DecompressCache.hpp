@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct FSNode;
+
+// LRU распакованного содержимого сжатых файлов: повторное чтение горячего файла
+// не гоняет кодек заново. Ёмкость — в байтах распакованных данных.
+// Запись по узлу действительна, пока узел жив и его содержимое не менялось:
+// Vfs сбрасывает её при каждом изменении файла (invalidate), а размер сжатых
+// байт сверяется при поиске на случай правки content в обход Vfs.
+class DecompressCache {
+public:
+    using Text = std::shared_ptr<const std::string>;
+
+    static constexpr std::size_t kDefaultCapacity = 64u << 20;
+
+    struct Stats {
+        std::uint64_t hits{0};
+        std::uint64_t misses{0};
+        std::uint64_t evictions{0};
+        std::size_t entries{0};
+        std::size_t bytes{0};
+        std::size_t capacity{0};
+        double hitRate() const noexcept {
+            const auto total = hits + misses;
+            return total ? static_cast<double>(hits) / static_cast<double>(total) : 0.0;
+        }
+    };
+
+    explicit DecompressCache(std::size_t capacity = kDefaultCapacity) : capacity_(capacity) {}
+
+    // nullptr — промах (учитывается в статистике).
+    Text find(const std::shared_ptr<FSNode>& node, std::size_t storedSize);
+    // Текст больше ёмкости не кэшируется.
+    void insert(const std::shared_ptr<FSNode>& node, std::size_t storedSize, Text text);
+    void invalidate(const FSNode* node);
+    void clear();
+
+    void setCapacity(std::size_t capacity);
+    Stats stats() const;
+    void resetStats();
+
+private:
+    struct Entry {
+        const FSNode* key;
+        std::weak_ptr<FSNode> owner;
+        std::size_t storedSize;
+        Text text;
+    };
+    using List = std::list<Entry>;
+
+    void eraseLocked(List::iterator it);
+    void evictLocked();
+
+    std::size_t capacity_;
+    std::size_t bytes_{0};
+    std::uint64_t hits_{0};
+    std::uint64_t misses_{0};
+    std::uint64_t evictions_{0};
+    List lru_;      // в начале — недавно прочитанные
+    std::unordered_map<const FSNode*, List::iterator> index_;
+    mutable std::mutex mu_;
+};
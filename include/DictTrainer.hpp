@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Обучение общего словаря для LZ_DICT (упрощённый COVER из zstd): из образцов
+// выбираются фрагменты, чьи k-граммы встречаются в наибольшем числе разных
+// файлов, пока словарь не наберёт maxBytes. Самые ценные фрагменты — в конце
+// словаря: ближе к данным, короче смещения.
+std::vector<std::uint8_t> trainDictionary(std::span<const std::span<const std::uint8_t>> samples,
+                                          std::size_t maxBytes);
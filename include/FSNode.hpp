@@ -6,13 +6,18 @@
 #include <map>
 #include <optional>
 #include <ctime>
+#include "Compression.hpp"
 #include "FileContent.hpp"
 
+// Для директорий charCount/byteSize и счётчики — агрегаты по всему поддереву
+// (сам узел в dirCount не входит).
 struct FileProperties {
     std::time_t createdAt{0};
     std::time_t modifiedAt{0};
     std::size_t charCount{0};
     std::size_t byteSize{0};
+    std::size_t fileCount{0};
+    std::size_t dirCount{0};
 };
 
 struct FSNode {
@@ -29,6 +34,17 @@ struct FSNode {
     FileContent content;
     FileProperties fileProps;
 
+    // Ленивая копия директории: дети ещё не созданы и будут взяты из lazySource
+    // при первом обращении. У источника lazyClones — ожидающие его копии.
+    std::shared_ptr<FSNode> lazySource;
+    std::vector<std::weak_ptr<FSNode>> lazyClones;
+
+    // Только у директорий; nullopt — действует политика ближайшего предка.
+    std::optional<CompressionPolicy> compression;
+    // Только у файлов: сжатие по политике не помогло, и при дозаписи файл
+    // пробуется снова лишь после того, как дорастёт до этого размера.
+    std::size_t compressRetrySize{0};
+
     std::shared_ptr<FSNode> getChild(const std::string& name, bool wantFile) const {
         auto it = children.find(name);
         if (it == children.end()) return nullptr;
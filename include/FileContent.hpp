@@ -1,43 +1,168 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <memory>
+#include <span>
+#include <variant>
 #include <vector>
 #include <string>
 #include <cstring>
 #include "Errors.hpp"
 
+class BlobStore;
+class HostFile;
+
+// Содержимое файла хранится одним из трёх способов:
+//  - до kInlineCapacity байт — прямо в объекте, без выделений в куче;
+//  - до страницы — одним разделяемым буфером;
+//  - больше — таблицей страниц фиксированного размера, поэтому запись, дозапись
+//    и усечение затрагивают только нужные страницы и никогда не перевыделяют весь файл.
+// Буферы и таблица страниц разделяемые (copy-on-write): копия FileContent копирует
+// только указатели, байты страницы копируются при первой записи в неё.
+// Таблица может опираться на отображённый файл хоста: пустая страница читается
+// прямо из отображения и копируется в память только при записи.
+// Пустая страница вне отображения — дыра: читается нулями и памяти не занимает,
+// поэтому запись далеко за концом и расширение truncate не выделяют промежуток.
 class FileContent {
 public:
     using byte = std::uint8_t;
+    using Buffer = std::vector<byte>;
+    using BufferPtr = std::shared_ptr<Buffer>;
+
+    static constexpr std::size_t kPageSize = 64 * 1024;
+    static constexpr std::size_t kInlineCapacity = 55;
+
+    std::size_t size() const noexcept;
+    bool isInline() const noexcept { return std::holds_alternative<Inline>(rep_); }
+    bool paged() const noexcept { return std::holds_alternative<TablePtr>(rep_); }
+    std::size_t pageCount() const noexcept { return paged() ? table().pages.size() : 0; }
+
+    // Копия содержимого одним буфером — O(n); на горячем пути используйте view/readInto.
+    Buffer bytes() const;
+
+    bool sharesStorageWith(const FileContent& other) const noexcept;
+    // Физический объём с учётом разделения буферов между файлами.
+    std::size_t physicalBytes() const noexcept;
+    // Оценка памяти в куче, приходящейся на этот файл (буферы, страницы, таблица).
+    std::size_t heapBytes() const noexcept;
+    // Байты, под которые действительно есть хранилище (без дыр), в отличие от size().
+    std::size_t allocatedBytes() const noexcept;
+    // Заменяет буферы каноническими экземплярами из хранилища (дедупликация).
+    void intern(BlobStore& store);
+
+    // Содержимое становится файлом хоста без копирования байтов.
+    void mapHostFile(std::shared_ptr<const HostFile> file);
+    bool hostBacked() const noexcept { return paged() && table().base != nullptr; }
+    // Сколько байт ещё читается из отображения (не скопировано записью).
+    std::size_t mappedBytes() const noexcept;
+
+    // fn(const byte* data, std::size_t n) — по всем непрерывным кускам по порядку.
+    template<class Fn>
+    void forEachChunk(Fn&& fn) const {
+        if (auto in = std::get_if<Inline>(&rep_)) {
+            if (in->len) fn(in->data.data(), static_cast<std::size_t>(in->len));
+        } else if (auto buf = std::get_if<BufferPtr>(&rep_)) {
+            fn((*buf)->data(), (*buf)->size());
+        } else {
+            const auto& t = table();
+            for (std::size_t i = 0; i < t.pages.size(); ++i) {
+                auto s = pageBytes(t, i);
+                fn(s.data(), s.size());
+            }
+        }
+    }
+
+    // fn(const void* id, std::size_t bytes) — по всем единицам хранения;
+    // встроенное содержимое считается отдельной единицей самого объекта.
+    template<class Fn>
+    void forEachStorageBlock(Fn&& fn) const {
+        if (auto in = std::get_if<Inline>(&rep_)) {
+            if (in->len) fn(static_cast<const void*>(this), static_cast<std::size_t>(in->len));
+        } else if (auto buf = std::get_if<BufferPtr>(&rep_)) {
+            fn(static_cast<const void*>(buf->get()), (*buf)->size());
+        } else {
+            // у страниц из отображения идентификатор — их адрес в отображении; дыры пропускаем
+            const auto& t = table();
+            for (std::size_t i = 0; i < t.pages.size(); ++i) {
+                if (const void* id = pageId(t, i)) fn(id, pageLen(t, i));
+            }
+        }
+    }
 
-    std::size_t size() const noexcept { return data_.size(); }
-    const std::vector<byte>& bytes() const noexcept { return data_; }
+    // Без копирования: самый длинный непрерывный кусок с позиции off, не длиннее n
+    // (на границе страницы может оказаться короче). Действителен до изменения файла.
+    std::span<const byte> view(std::size_t off, std::size_t n) const;
+    // Копирует до dst.size() байт с позиции off в dst, возвращает число скопированных.
+    std::size_t readInto(std::size_t off, std::span<byte> dst) const;
 
-    void write(std::size_t off, const std::vector<byte>& buf);
-    void append(const std::vector<byte>& buf);
+    // Запись допускается с любого смещения: промежуток за концом становится дырой.
+    void write(std::size_t off, std::span<const byte> buf);
+    void write(std::size_t off, const std::vector<byte>& buf) { write(off, std::span<const byte>(buf)); }
+    void append(std::span<const byte> buf);
+    void append(const std::vector<byte>& buf) { append(std::span<const byte>(buf)); }
     std::vector<byte> read(std::size_t off, std::size_t n) const;
 
     template<class T>
     void writeValue(std::size_t off, const T& v) {
-        const byte* p = reinterpret_cast<const byte*>(&v);
-        write(off, std::vector<byte>(p, p + sizeof(T)));
+        write(off, std::span<const byte>(reinterpret_cast<const byte*>(&v), sizeof(T)));
     }
 
     template<class T>
     T readValue(std::size_t off) const {
-        auto b = read(off, sizeof(T));
-        if (b.size() != sizeof(T))
-            throw VfsException(ErrorCode::ReadError);
         T v{};
-        std::memcpy(&v, b.data(), sizeof(T));
+        if (readInto(off, std::span<byte>(reinterpret_cast<byte*>(&v), sizeof(T))) != sizeof(T))
+            throw VfsException(ErrorCode::ReadError);
         return v;
     }
 
     void truncate(std::size_t newSize);
-    void replaceAll(const std::vector<byte>& buf);
+    void replaceAll(std::span<const byte> buf);
+    void replaceAll(const std::vector<byte>& buf) { replaceAll(std::span<const byte>(buf)); }
+    // Забирает буфер целиком, без копирования байтов.
+    void replaceAll(std::vector<byte>&& buf);
 
-    void assignText(const std::string& s) { replaceAll(std::vector<byte>(s.begin(), s.end())); }
-    std::string asText() const { return std::string(data_.begin(), data_.end()); }
+    void assignText(const std::string& s) {
+        replaceAll(std::span<const byte>(reinterpret_cast<const byte*>(s.data()), s.size()));
+    }
+    void appendText(const std::string& s) {
+        append(std::span<const byte>(reinterpret_cast<const byte*>(s.data()), s.size()));
+    }
+    std::string asText() const;
 
 private:
-    std::vector<byte> data_;
-};
\ No newline at end of file
+    struct Inline {
+        // Явный конструктор: инициализаторы членов вложенного класса недоступны,
+        // пока FileContent не определён, и variant не видел бы конструктор по умолчанию.
+        Inline() noexcept : len(0), data{} {}
+        std::uint8_t len;
+        std::array<byte, kInlineCapacity> data;
+    };
+    struct PageTable {
+        std::vector<BufferPtr> pages;   // nullptr — страница из base или дыра
+        std::size_t size{0};
+        std::shared_ptr<const HostFile> base;
+        std::size_t baseSize{0};        // сколько байт base ещё видно (после усечения меньше)
+    };
+    using TablePtr = std::shared_ptr<PageTable>;
+
+    static std::size_t pageLen(const PageTable& t, std::size_t idx) noexcept {
+        return std::min(kPageSize, t.size - idx * kPageSize);
+    }
+    static bool fromBase(const PageTable& t, std::size_t idx) noexcept {
+        return !t.pages[idx] && idx * kPageSize < t.baseSize;
+    }
+    static std::span<const byte> pageBytes(const PageTable& t, std::size_t idx) noexcept;
+    static const void* pageId(const PageTable& t, std::size_t idx) noexcept;
+
+    const PageTable& table() const { return *std::get<TablePtr>(rep_); }
+    PageTable& mutableTable();
+    Buffer& mutablePage(PageTable& t, std::size_t idx);
+    void writeBytes(std::size_t off, const byte* src, std::size_t n);
+    void copyOut(std::size_t off, byte* dst, std::size_t n) const;
+    void toPaged();
+    void extendPaged(std::size_t newSize);
+    void shrinkRepresentation();
+
+    std::variant<Inline, BufferPtr, TablePtr> rep_;
+};
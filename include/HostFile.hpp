@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Файл хоста, отображённый в память только для чтения (mmap). Страницы
+// подгружаются ядром по требованию и не считаются памятью процесса,
+// поэтому импорт большого файла не копирует его и не удваивает RSS.
+// Без mmap (Windows) файл просто читается в буфер.
+class HostFile {
+public:
+    static std::shared_ptr<const HostFile> open(const std::string& path);
+
+    HostFile(const HostFile&) = delete;
+    HostFile& operator=(const HostFile&) = delete;
+    ~HostFile();
+
+    const std::uint8_t* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+    const std::string& path() const noexcept { return path_; }
+
+private:
+    HostFile() = default;
+
+    std::string path_;
+    const std::uint8_t* data_{nullptr};
+    std::size_t size_{0};
+    bool mapped_{false};
+    std::vector<std::uint8_t> fallback_;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Быстрый LZ77 в духе LZ4: выровненные по байтам последовательности
+// «литералы + совпадение», поиск совпадений по хеш-цепочкам.
+// Сжимает блок целиком (совпадения — только внутри блока и общего словаря,
+// если он задан), распаковка — копирование без битовых операций.
+//
+// Последовательность: токен (старшие 4 бита — число литералов, младшие — длина
+// совпадения минус kMinMatch; 15 — продолжение байтами по 255), литералы,
+// смещение (2 байта LE, 1..kMaxOffset), продолжение длины совпадения.
+// Последняя последовательность — только литералы, на ней вход заканчивается.
+
+namespace lzfast {
+
+constexpr std::size_t kMinMatch = 4;
+constexpr std::size_t kMaxOffset = 65535;
+
+// Разбор блока на последовательности; общий для LZ_FAST и кодеков, которые
+// дальше кодируют последовательности по-своему (энтропийно).
+struct Sequence {
+    std::uint32_t litLen;    // литералов перед совпадением
+    std::uint32_t offset;
+    std::uint32_t matchLen;  // 0 — последняя последовательность, только литералы
+};
+
+class MatchFinder {
+public:
+    // maxChain — сколько кандидатов цепочки проверять; lazy — сравнивать
+    // совпадение со следующей позицией и брать лучшее (медленнее, плотнее).
+    MatchFinder(int maxChain, bool lazy) noexcept : maxChain_(maxChain), lazy_(lazy) {}
+
+    // Последовательности in с позиции start по порядку; последняя — только литералы.
+    // [0, start) — только история для совпадений (общий словарь).
+    void parse(std::span<const std::uint8_t> in, std::vector<Sequence>& out, std::size_t start = 0);
+
+private:
+    static constexpr int kHashBits = 16;
+    // Совпадение такой длины принимается сразу, без поиска лучшего.
+    static constexpr std::size_t kGoodMatch = 32;
+    static constexpr std::uint32_t kNone = 0xFFFFFFFFu;
+
+    std::uint32_t hashAt(const std::uint8_t* p) const noexcept;
+    void insert(const std::uint8_t* src, std::size_t pos) noexcept;
+    // Лучшее совпадение для pos (позиция вставляется в цепочку); длина 0 — нет.
+    std::size_t longest(const std::uint8_t* src, std::size_t n, std::size_t pos, std::size_t& offset) noexcept;
+
+    int maxChain_;
+    bool lazy_;
+    std::vector<std::uint32_t> head_;
+    std::vector<std::uint32_t> chain_;   // предыдущая позиция с тем же хешем
+};
+
+class Compressor {
+public:
+    // Дописывает сжатый in в out. Совпадения могут ссылаться в dict (до 64 KiB
+    // назад от начала in), распаковке нужен тот же dict.
+    void compress(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out,
+                  std::span<const std::uint8_t> dict = {});
+
+private:
+    // Сколько кандидатов цепочки проверять: дальше выигрыш в степени сжатия мал.
+    static constexpr int kMaxChain = 8;
+
+    MatchFinder finder_{kMaxChain, false};
+    std::vector<Sequence> seqs_;
+    std::vector<std::uint8_t> window_;   // словарь + вход
+};
+
+// Дописывает в out ровно expected байт; при любом несоответствии — Corrupted.
+// dict — тот же общий словарь, что при сжатии.
+void decompress(std::span<const std::uint8_t> in, std::size_t expected, std::vector<std::uint8_t>& out,
+                std::span<const std::uint8_t> dict = {});
+
+} // namespace lzfast
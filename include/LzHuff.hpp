@@ -0,0 +1,34 @@
+#pragma once
+#include "LzFast.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// LZ77 + канонический Хаффман (в духе deflate) для архивного хранения:
+// те же последовательности, что у LZ_FAST (глубже поиск и ленивый разбор),
+// но литералы, длины и смещения кодируются кодами переменной длины.
+//
+// Блок: длины кодов обоих алфавитов по 4 бита, затем битовый поток (от младшего
+// бита) из символов «литерал/длина» и «смещение» с дополнительными битами,
+// завершённый символом конца блока. Коды не длиннее kMaxCodeLen, поэтому
+// распаковка — один просмотр таблицы на символ.
+
+namespace lzhuff {
+
+constexpr int kMaxCodeLen = 12;
+
+class Compressor {
+public:
+    // Дописывает сжатый in в out.
+    void compress(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out);
+
+private:
+    lzfast::MatchFinder finder_{32, true};
+    std::vector<lzfast::Sequence> seqs_;
+};
+
+// Дописывает в out ровно expected байт; при любом несоответствии — Corrupted.
+void decompress(std::span<const std::uint8_t> in, std::size_t expected, std::vector<std::uint8_t>& out);
+
+} // namespace lzhuff
@@ -0,0 +1,230 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+// Потоковый LZW с переменной разрядностью кода (9..16 бит).
+// Вход подаётся кусками любого размера, выход дописывается в out по мере готовности,
+// поэтому рабочая память не зависит от размера файла: словарь плюс один кусок.
+// alphaOnly: в словарь попадают только фразы из ASCII-букв (режим ALPHA).
+
+namespace lzw {
+
+constexpr int kMinBits = 9;
+constexpr int kMaxBits = 16;
+constexpr std::uint32_t kFirstFree = 256;
+constexpr std::uint32_t kDictLimit = 1u << kMaxBits;
+
+// Разрядность растёт до maxBits (не больше kMaxWideBits; форматы ALL/ALPHA — 16).
+// Режим со сбросом словаря: код kClearCode начинает словарь заново.
+constexpr std::uint32_t kClearCode = 256;
+constexpr int kMaxWideBits = 24;
+constexpr int kDefaultWideBits = 20;
+
+struct Params {
+    bool alphaOnly{false};
+    // Поток начинается байтом maxBits, код 256 зарезервирован под CLEAR. Кодер
+    // шлёт CLEAR, когда степень сжатия на заполненном словаре начинает падать.
+    bool clearCode{false};
+    int maxBits{kMaxBits};
+};
+
+// Биты идут от младшего к старшему. Оба класса копят биты в 64-битном
+// аккумуляторе и обмениваются с памятью целыми словами.
+
+// Пишет в заранее выделенную память без проверок: вызывающий гарантирует место
+// (begin/end обрамляют одну порцию). Неполный байт переживает end.
+class BitWriter {
+public:
+    void begin(std::uint8_t* dst) noexcept { cur_ = dst; }
+
+    void put(std::uint32_t value, int nbits) noexcept {
+        acc_ |= static_cast<std::uint64_t>(value & ((1u << nbits) - 1u)) << count_;
+        count_ += nbits;
+        if (count_ >= 32) {
+            storeLE32(cur_, static_cast<std::uint32_t>(acc_));
+            cur_ += 4;
+            acc_ >>= 32;
+            count_ -= 32;
+        }
+    }
+    // Дополняет нулями до границы байта.
+    void alignToByte() noexcept { count_ = (count_ + 7) & ~7; }
+    // Сбрасывает накопленные целые байты; возвращает позицию за последним.
+    std::uint8_t* end() noexcept {
+        while (count_ >= 8) {
+            *cur_++ = static_cast<std::uint8_t>(acc_);
+            acc_ >>= 8;
+            count_ -= 8;
+        }
+        return cur_;
+    }
+
+    // Сколько байт может записать порция из codes кодов (с выравниваниями);
+    // clears — сколько в ней может быть сбросов словаря.
+    static constexpr std::size_t maxBytesFor(std::size_t codes, int maxBits = kMaxBits,
+                                             std::size_t clears = 0) noexcept {
+        const auto codeBytes = static_cast<std::size_t>((maxBits + 7) / 8);
+        const auto widenings = static_cast<std::size_t>(maxBits - kMinBits + 1);
+        return (codes + clears) * codeBytes + (clears + 1) * widenings + 8;
+    }
+
+private:
+    static void storeLE32(std::uint8_t* p, std::uint32_t v) noexcept {
+        p[0] = static_cast<std::uint8_t>(v);
+        p[1] = static_cast<std::uint8_t>(v >> 8);
+        p[2] = static_cast<std::uint8_t>(v >> 16);
+        p[3] = static_cast<std::uint8_t>(v >> 24);
+    }
+
+    std::uint8_t* cur_{nullptr};
+    std::uint64_t acc_{0};
+    int count_{0};
+};
+
+// Читатель с подкачкой: refill грузит сразу 8 байт (быстрый путь, когда впереди
+// их достаточно), push — по одному байту у конца входа.
+class BitReader {
+public:
+    // Требует 8 доступных байт с p; возвращает, сколько из них поглощено.
+    std::size_t refill(const std::uint8_t* p) noexcept {
+        std::uint64_t word = 0;
+        for (int i = 0; i < 8; ++i) word |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+        acc_ |= word << count_;
+        std::size_t used = static_cast<std::size_t>((63 - count_) >> 3);
+        count_ |= 56;
+        return used;
+    }
+    bool canPush() const noexcept { return count_ <= 56; }
+    void push(std::uint8_t b) noexcept {
+        acc_ |= static_cast<std::uint64_t>(b) << count_;
+        count_ += 8;
+    }
+    bool get(int nbits, std::uint32_t& value) noexcept {
+        if (count_ < nbits) return false;
+        value = static_cast<std::uint32_t>(acc_) & ((1u << nbits) - 1u);
+        acc_ >>= nbits;
+        count_ -= nbits;
+        return true;
+    }
+    // Отбрасывает остаток текущего байта.
+    void alignToByte() noexcept {
+        int partial = count_ & 7;
+        acc_ >>= partial;
+        count_ -= partial;
+    }
+
+private:
+    // Биты выше count_ могут содержать уже прочитанные refill байты — они
+    // совпадают с тем, что будет подгружено следующим, поэтому |= безопасно.
+    std::uint64_t acc_{0};
+    int count_{0};
+};
+
+// Словарь кодера — (код префикса, байт) -> код в плоской таблице с открытой
+// адресацией: шаг цикла — один хеш пары чисел, без строк и выделений памяти.
+class Encoder {
+public:
+    explicit Encoder(bool alphaOnly) : Encoder(Params{alphaOnly}) {}
+    explicit Encoder(const Params& params);
+
+    void feed(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out);
+    // Выводит последний код и дополняет поток до байта.
+    void finish(std::vector<std::uint8_t>& out);
+    // Начинает новый независимый поток, не перевыделяя словарь.
+    void reset();
+
+private:
+    static constexpr std::uint32_t kEmpty = 0;
+    // Как часто (в байтах входа) проверять степень сжатия на заполненном словаре.
+    static constexpr std::uint64_t kCheckGap = 64 * 1024;
+
+    struct Slot {
+        std::uint32_t key;    // (prefix << 8 | byte) + 1, 0 — пусто
+        std::uint32_t code;
+    };
+
+    std::uint32_t slotOf(std::uint32_t key) const noexcept {
+        return (key * 0x9E3779B1u) >> (32 - tableBits_);
+    }
+    bool ratioDropped(std::uint64_t pos) noexcept;
+    void restartDictionary() noexcept;
+
+    bool alphaOnly_;
+    bool clearCode_;
+    int maxBits_;
+    std::uint32_t dictLimit_;
+    std::uint32_t firstFree_;
+    int tableBits_;     // ячеек вдвое больше кодов — заполнение до 1/2
+    std::unique_ptr<Slot[]> table_;
+    // Занятые ячейки: сброс словаря чистит только их, а не всю таблицу.
+    std::vector<std::uint32_t> used_;
+    // ALPHA: состоит ли фраза с данным кодом только из букв.
+    std::vector<std::uint8_t> letters_;
+    std::uint32_t w_{0};
+    bool started_{false};
+    std::uint32_t nextCode_{kFirstFree};
+    int codeBits_{kMinBits};
+    BitWriter writer_;
+    // Режим со сбросом: позиции во входе потока и биты, выданные с заполнения словаря.
+    std::uint64_t fed_{0};
+    bool full_{false};
+    std::uint64_t fullAt_{0};
+    std::uint64_t nextCheck_{0};
+    std::uint64_t bitsSinceFull_{0};
+    std::uint64_t bestRatio_{0};
+};
+
+// Словарь декодера — плоские массивы (код префикса, последний байт, длина):
+// фраза выписывается с конца прямо в выходной буфер, без строк на каждую запись.
+class Decoder {
+public:
+    explicit Decoder(bool alphaOnly) : Decoder(Params{alphaOnly}) {}
+    // В режиме со сбросом maxBits берётся из потока, а params.maxBits — его
+    // верхняя граница: поток с большей разрядностью — Corrupted.
+    explicit Decoder(const Params& params);
+
+    void feed(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out);
+    // Проверяет, что поток не оборвался до первого кода.
+    void finish();
+    // Начинает новый поток. Вывод прежнего потока в out окном уже не считается:
+    // следующий feed должен получить пустой out.
+    void reset();
+
+private:
+    void onCode(std::uint32_t code, std::vector<std::uint8_t>& out);
+    void emit(std::uint32_t code, std::vector<std::uint8_t>& out);
+    void widenIfNeeded();
+    void setMaxBits(int maxBits);
+    void grow();
+    void restartDictionary() noexcept;
+
+    bool alphaOnly_;
+    bool clearCode_;
+    bool haveMaxBits_;
+    int bitsLimit_;                 // разрядность, больше которой поток не бывает
+    int maxBits_{kMaxBits};
+    std::uint32_t dictLimit_{kDictLimit};
+    std::uint32_t firstFree_;
+    // Массивы растут по мере заполнения словаря, а не по разрядности из потока.
+    // link_[code] = код префикса << 8 | последний байт: один доступ на байт фразы
+    std::vector<std::uint32_t> link_;
+    std::vector<std::uint32_t> length_;
+    std::vector<std::uint8_t> first_;
+    std::vector<std::uint8_t> letters_;
+    // start_[code] — абсолютная позиция в выводе, где фраза уже встречалась целиком
+    std::vector<std::uint64_t> start_;
+    std::uint64_t produced_{0};
+    std::uint64_t windowBase_{0};
+    std::uint64_t prevStart_{0};
+    std::uint32_t prev_{0};
+    bool started_{false};
+    bool sawInput_{false};
+    std::uint32_t nextCode_{kFirstFree};
+    int codeBits_{kMinBits};
+    BitReader reader_;
+};
+
+} // namespace lzw
@@ -1,20 +1,27 @@
 #pragma once
 #include "FileContent.hpp"
+#include "Compression.hpp"
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
 enum class StreamMode {
     ReadOnly,
     WriteOnly,
-    ReadWrite
+    ReadWrite,
+    // Только чтение сжатого файла: поток отдаёт распакованные байты,
+    // позиции (Tell/Seek) считаются в распакованных данных; Seek распаковывает
+    // только блок с новой позицией.
+    ReadDecompressed
 };
 
 class OIStream {
 public:
-    OIStream(FileContent& file, StreamMode mode, std::size_t bufSize);
+    // dicts — словари для ReadDecompressed файлов LZ_DICT.
+    OIStream(FileContent& file, StreamMode mode, std::size_t bufSize, DictionaryLookup dicts = {});
 
     void Open();
     void Close();
@@ -62,4 +69,6 @@ private:
     bool dirty_{false};
     bool eof_{false};
     BufferRole role_{BufferRole::Idle};
+    std::unique_ptr<DecompressReader> decomp_;
+    DictionaryLookup dicts_;
 };
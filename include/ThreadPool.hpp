@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Фиксированный пул потоков для параллельных циклов (блоки сжатия и т.п.).
+// Вызывающий поток работает наравне с остальными, поэтому пул из одного
+// потока не создаёт ни одного дополнительного. Циклы из разных потоков идут
+// по очереди; parallelFor изнутри задачи любого пула выполняется на месте.
+class ThreadPool {
+public:
+    using Job = std::function<void(std::size_t index, unsigned worker)>;
+
+    // threads == 0 — по числу ядер.
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const noexcept { return static_cast<unsigned>(workers_.size()) + 1; }
+    static unsigned defaultThreads() noexcept;
+    // Общий пул процесса по числу ядер: создаётся при первом обращении, и
+    // короткие циклы (сжатие одного файла) не заводят потоки на каждый вызов.
+    static ThreadPool& shared();
+
+    // fn(i, worker) для каждого i из [0, n), worker < size() — номер потока
+    // (для рабочих буферов на поток). Возвращается, когда все вызовы завершены;
+    // первое исключение пробрасывается, оставшиеся индексы не запускаются.
+    // limit — сколько потоков, включая вызывающий, берут работу (0 — все);
+    // тогда и worker < limit.
+    void parallelFor(std::size_t n, const Job& fn, unsigned limit = 0);
+
+private:
+    void workerLoop(unsigned worker);
+    void runJob(unsigned worker);
+
+    std::vector<std::thread> workers_;
+    std::mutex callMu_;     // один цикл за раз
+    std::mutex mu_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const Job* job_{nullptr};
+    std::size_t jobSize_{0};
+    unsigned active_{0};    // рабочие с номером не меньше — в этом цикле не участвуют
+    std::atomic<std::size_t> next_{0};
+    std::uint64_t generation_{0};
+    unsigned busy_{0};
+    std::exception_ptr error_;
+    bool stop_{false};
+};
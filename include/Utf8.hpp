@@ -0,0 +1,11 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace Utf8 {
+
+// Количество кодовых точек UTF-8: считаются все байты, кроме продолжений (10xxxxxx).
+// Счёт аддитивен, поэтому его можно вести по частям при дозаписи.
+std::size_t countCodePoints(const std::uint8_t* data, std::size_t n) noexcept;
+
+}
@@ -1,11 +1,17 @@
 #pragma once
 
 #include "Compression.hpp"
+#include "DecompressCache.hpp"
 #include "FSNode.hpp"
 #include "BStarTree.hpp"
+#include "BlobStore.hpp"
 #include "Errors.hpp"
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class Vfs {
@@ -14,6 +20,22 @@ public:
     using WNodePtr = std::weak_ptr<FSNode>;
     using IndexBucket = std::shared_ptr<std::vector<WNodePtr>>;
     enum class ResolveKind { Any, File, Directory };
+    // Lazy: директория копируется за O(1), дети создаются при первом обращении.
+    enum class CopyMode { Eager, Lazy };
+    struct DedupStats {
+        std::size_t files{0};
+        std::size_t logicalBytes{0};
+        std::size_t physicalBytes{0};
+        std::size_t blobs{0};
+    };
+    // Оценка памяти поддерева: сами узлы (с именами и картой детей) и содержимое в куче.
+    struct MemoryStats {
+        std::size_t nodes{0};
+        std::size_t inlineFiles{0};
+        std::size_t nodeBytes{0};
+        std::size_t contentBytes{0};
+        std::size_t total() const noexcept { return nodeBytes + contentBytes; }
+    };
 
     Vfs();
 
@@ -25,28 +47,84 @@ public:
     void rm(const std::string& path);
     void renameNode(const std::string& path, const std::string& newName);
     void mv(const std::string& src, const std::string& dstDir);
-    void cp(const std::string& src, const std::string& dstPath);
+    void cp(const std::string& src, const std::string& dstPath, CopyMode mode = CopyMode::Eager);
     void writeFile(const std::string& path, const std::string& content, bool append);
-    void compress(const std::string& path, CompAlgo algo = CompAlgo::LZW_VAR_ALL);
-    void decompress(const std::string& path);
+    // Каталог обрабатывается рекурсивно: файлы поддерева сжимаются параллельно,
+    // статистика обновляется после каждого файла. threads — 0 — по числу ядер.
+    // CompAlgo::AUTO выбирает алгоритм для каждого файла отдельно. Файл, который
+    // с заголовком CMP не стал бы меньше (пустой, крошечный), остаётся как есть.
+    // dictId — общий словарь из kDictDir (обязателен для LZ_DICT, для AUTO — кандидат).
+    void compress(const std::string& path, CompAlgo algo = CompAlgo::LZW_VAR_ALL, unsigned threads = 0,
+                  const AutoObjective& objective = {}, std::uint32_t dictId = 0);
+    void decompress(const std::string& path, unsigned threads = 0);
+
+    // Общие словари лежат файлами kDictDir/<id в hex> и сами не сжимаются.
+    static constexpr const char* kDictDir = "/.dict";
+    // Обучает словарь на файлах поддерева dir и сохраняет его; возвращает id.
+    std::uint32_t trainDictionary(const std::string& dir, std::size_t maxBytes = kMaxDictionary);
+    [[nodiscard]] DictionaryPtr loadDictionary(std::uint32_t id) const;
+    // Снимок всех словарей: результат можно вызывать из нескольких потоков.
+    [[nodiscard]] DictionaryLookup dictionaryLookup() const;
+
+    // Прозрачное сжатие: под каталогом с политикой файлы сжимаются после каждой
+    // записи, а readFile и дозапись видят распакованное содержимое. Дозапись
+    // через writeFile пересжимает только последний блок. nullopt — наследовать
+    // от предка. Уже лежащие файлы не трогает (для них — compress).
+    void setCompressionPolicy(const std::string& dir, std::optional<CompressionPolicy> policy);
+    // Собственная политика каталога (nullopt — не задана).
+    [[nodiscard]] std::optional<CompressionPolicy> compressionPolicy(const std::string& dir) const;
+    // Действующая для узла: ближайшая заданная у него или предков; nullptr — сжатия нет.
+    [[nodiscard]] const CompressionPolicy* effectivePolicy(const NodePtr& node) const;
+    [[nodiscard]] DecompressCache::Stats cacheStats() const { return cache_->stats(); }
+    void setCacheCapacity(std::size_t bytes) { cache_->setCapacity(bytes); }
+    // Файл хоста подключается через mmap без копирования; запись в VFS копирует
+    // только затронутые страницы, сам файл хоста не меняется.
+    void importHostFile(const std::string& hostPath, const std::string& path);
 
     void writeToFile(const std::string& path, const std::string& content);
     [[nodiscard("check file content")]] std::string readFile(const std::string& path) const;
     [[nodiscard("check node")]] NodePtr resolve(const std::string& path, ResolveKind preference = ResolveKind::Any) const;
+    [[nodiscard("check node")]] NodePtr resolveForWrite(const std::string& path);
     void refreshNodeStats(const NodePtr& node);
+    void refreshNodeStatsAfterAppend(const NodePtr& node, const std::uint8_t* data, std::size_t n);
 
     void ls(const std::string& path = "") const;
     void printTree() const;
 
     [[nodiscard("check if nodes found")]] std::vector<NodePtr> findNodesByName(const std::string& name) const;
 
+    // Дедупликация содержимого: включение сразу сворачивает уже существующие дубликаты.
+    void setDedup(bool enabled);
+    [[nodiscard]] bool dedupEnabled() const noexcept { return static_cast<bool>(blobStore_); }
+    [[nodiscard]] DedupStats dedupStats() const;
+    // charCount по умолчанию — число байт; включённый подсчёт считает кодовые точки
+    // UTF-8 (векторный счётчик). Переключение пересчитывает всё дерево.
+    void setCountCodePoints(bool enabled);
+    [[nodiscard]] bool countCodePoints() const noexcept { return countCodePoints_; }
+    [[nodiscard]] MemoryStats memoryUsage(const std::string& path = "") const;
+    [[nodiscard]] static std::size_t nodeMemory(const FSNode& node) noexcept;
+
     void saveJson(const std::string& jsonPath);
     void loadJson(const std::string& jsonPath);
 
 private:
+    struct StatsDelta {
+        std::int64_t bytes{0};
+        std::int64_t chars{0};
+        std::int64_t files{0};
+        std::int64_t dirs{0};
+    };
+
     NodePtr root_;
     NodePtr cwd_;
-    BStarTree<std::string, IndexBucket> nameIndex_;
+    mutable BStarTree<std::string, IndexBucket> nameIndex_;
+    mutable std::vector<WNodePtr> lazyDirs_;
+    std::unique_ptr<BlobStore> blobStore_;
+    // распакованные сжатые файлы для readFile; сбрасывается в touchNode
+    std::unique_ptr<DecompressCache> cache_;
+    // Разобранные словари по id вместе с их файлом; сбрасываются при записи в kDictDir.
+    mutable std::unordered_map<std::uint32_t, std::pair<NodePtr, DictionaryPtr>> dictionaries_;
+    bool countCodePoints_{false};
 
     [[nodiscard("check parent")]] NodePtr resolveParent(const std::string& path, std::string& leafName) const;
 
@@ -56,12 +134,39 @@ private:
 
     std::string makeUniqueName(const NodePtr& parent, const std::string& base, bool isFile) const;
     NodePtr copyNodeRec(const NodePtr& src, const NodePtr& destParent, const std::string& name);
-    void compressNode(const NodePtr& node);
-    void decompressNode(const NodePtr& node);
+    std::vector<NodePtr> collectFilesForWrite(const NodePtr& node) const;
+    std::vector<NodePtr> withoutDictionaries(std::vector<NodePtr> files) const;
+    DictionaryPtr findDictionaryFile(std::uint32_t id) const;
+    // Распакованное содержимое сжатого файла (через кэш).
+    DecompressCache::Text decompressedText(const NodePtr& f) const;
+    bool inDictionaryDir(const NodePtr& f) const;
+    // Сжатый файл перед дозаписью распаковывается; true — был сжат.
+    bool expandForWrite(const NodePtr& f);
+    // Дозапись в файл, сжатый по политике, без распаковки целиком; false — не вышло.
+    bool appendCompressedFile(const NodePtr& f, std::span<const std::uint8_t> data);
+    // Сжимает файл по действующей политике; true — содержимое изменилось.
+    // appended — файл только дописан: после неудачной попытки сжатие не
+    // повторяется на каждой дозаписи. Без словаря политики файл остаётся несжатым.
+    bool compressOnWrite(const NodePtr& f, bool appended);
+    // fn(content, threads) для каждого файла; true — содержимое изменилось.
+    void transformFiles(const std::vector<NodePtr>& files, unsigned threads,
+                        const std::function<bool(FileContent&, unsigned)>& fn);
     void initNodeProps(const NodePtr& node);
     void touchNode(const NodePtr& node);
+    void recountFileStats(const NodePtr& node);
+    std::size_t countChars(const FileContent& content) const;
+    void applyFileStats(const NodePtr& node, std::size_t size, std::size_t chars);
+    void accountAppend(const NodePtr& node, const std::uint8_t* data, std::size_t n);
+    static StatsDelta subtreeTotals(const NodePtr& node);
+    static void propagateStats(const NodePtr& dir, const StatsDelta& d, int sign = 1);
+
+    void attachLazy(const NodePtr& clone, const NodePtr& source) const;
+    void materialize(const NodePtr& dir) const;
+    void materializeAll() const;
+    void releasePins(const NodePtr& dir) const;
+    void unpinForWrite(const NodePtr& node) const;
 
-    void indexInsert(const NodePtr& n);
+    void indexInsert(const NodePtr& n) const;
     void indexErase(const NodePtr& n);
     void indexEraseSubtree(const NodePtr& n);
 };
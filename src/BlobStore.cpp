@@ -0,0 +1,85 @@
+#include "BlobStore.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr std::uint64_t kMul1 = 0x9E3779B97F4A7C15ull;
+constexpr std::uint64_t kMul2 = 0xC2B2AE3D27D4EB4Full;
+
+std::uint64_t mix(std::uint64_t h) noexcept {
+    h ^= h >> 33;
+    h *= kMul2;
+    h ^= h >> 29;
+    return h;
+}
+
+}
+
+std::uint64_t BlobStore::hashBytes(const std::uint8_t* data, std::size_t n) noexcept {
+    // Пословный хэш: четыре независимые полосы по 8 байт.
+    std::uint64_t h[4] = {n * kMul1, kMul2, kMul1 ^ kMul2, ~kMul1};
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            std::uint64_t w;
+            std::memcpy(&w, data + i + lane * 8, sizeof(w));
+            h[lane] = (h[lane] ^ w) * kMul1;
+            h[lane] ^= h[lane] >> 31;
+        }
+    }
+    std::uint64_t acc = mix(h[0]) ^ (mix(h[1]) * 3) ^ (mix(h[2]) * 5) ^ (mix(h[3]) * 7);
+    for (; i + 8 <= n; i += 8) {
+        std::uint64_t w;
+        std::memcpy(&w, data + i, sizeof(w));
+        acc = mix((acc ^ w) * kMul1);
+    }
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, data + i, n - i);
+    return mix((acc ^ tail ^ (n << 56)) * kMul1);
+}
+
+BlobStore::BufferPtr BlobStore::intern(const BufferPtr& buf) {
+    if (!buf || buf->empty()) return buf;
+    auto h = hashBytes(buf->data(), buf->size());
+
+    std::lock_guard<std::mutex> lock(mu_);
+    auto& bucket = buckets_[h];
+    BufferPtr found;
+    // Попутно выбрасываем мёртвые записи и буферы, изменённые после регистрации.
+    bucket.erase(std::remove_if(bucket.begin(), bucket.end(), [&](const std::weak_ptr<Buffer>& w) {
+        auto sp = w.lock();
+        if (!sp) return true;
+        if (sp->size() != buf->size()) return hashBytes(sp->data(), sp->size()) != h;
+        if (!found && (sp == buf || std::memcmp(sp->data(), buf->data(), buf->size()) == 0)) {
+            found = sp;
+            return false;
+        }
+        return hashBytes(sp->data(), sp->size()) != h;
+    }), bucket.end());
+
+    if (found) return found;
+    bucket.push_back(buf);
+    if (buckets_.size() >= sweepAt_) {
+        sweepLocked();
+        sweepAt_ = std::max(kMinSweep, 2 * buckets_.size());
+    }
+    return buf;
+}
+
+std::size_t BlobStore::bucketCount() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return buckets_.size();
+}
+
+void BlobStore::sweepLocked() {
+    for (auto it = buckets_.begin(); it != buckets_.end(); ) {
+        auto& bucket = it->second;
+        bucket.erase(std::remove_if(bucket.begin(), bucket.end(),
+                                    [](const std::weak_ptr<Buffer>& w) { return w.expired(); }),
+                     bucket.end());
+        if (bucket.empty()) it = buckets_.erase(it);
+        else ++it;
+    }
+}
@@ -1,13 +1,18 @@
 #include "Compression.hpp"
+#include "Crc32c.hpp"
 #include "Errors.hpp"
 #include "FileContent.hpp"
-
+#include "Lzw.hpp"
+#include "LzFast.hpp"
+#include "LzHuff.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <vector>
-#include <string>
-#include <unordered_map>
-#include <optional>
-#include <cctype>
 
 namespace {
 
@@ -22,332 +27,686 @@ std::uint64_t get64(const std::uint8_t* p) {
     return v;
 }
 
-// ======= Писатель/читатель битов с выравниванием при смене разрядности =======
+void put32(std::vector<std::uint8_t>& out, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<std::uint8_t>((v >> (8 * i)) & 0xFFu));
+}
+std::uint32_t get32(const std::uint8_t* p) {
+    std::uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= (std::uint32_t)p[i] << (8 * i);
+    return v;
+}
 
-class BitWriter {
-public:
-    BitWriter() : bitbuf_(0), bitCount_(0) {}
-
-    void put(std::uint32_t value, int nbits) {
-        if (nbits <= 0) return;
-        std::uint32_t mask = (nbits == 32 ? 0xFFFFFFFFu : ((1u << nbits) - 1u));
-        value &= mask;
-        bitbuf_ |= (value << bitCount_);
-        bitCount_ += nbits;
-        while (bitCount_ >= 8) {
-            out_.push_back(static_cast<std::uint8_t>(bitbuf_ & 0xFFu));
-            bitbuf_ >>= 8;
-            bitCount_ -= 8;
-        }
-    }
+// Размер куска, которым вход подаётся кодеру/декодеру.
+constexpr std::size_t kStreamChunk = 64 * 1024;
+// v3: 'CMP', версия, алгоритм, исходный размер (8 байт), далее один поток LZW.
+constexpr std::size_t kHeaderSizeV3 = 13;
+// v4: то же, размер блока (4 байта), число блоков (4 байта), затем концы блоков
+// (по 8 байт, смещения в файле) и сами блоки подряд.
+constexpr std::size_t kHeaderSizeV4 = 21;
+// v5: заголовок как у v4, но запись таблицы — конец блока (8 байт) и CRC32C
+// его исходных данных (4 байта).
+constexpr std::uint8_t kVersion = 5;
+// Сколько распакованного вывода держит DecompressReader для копирования фраз.
+constexpr std::size_t kHistory = 1024 * 1024;
+
+bool knownVersion(std::uint8_t version) {
+    return version >= 3 && version <= kVersion;
+}
 
-    void alignToByte() {
-        if (bitCount_ > 0) {
-            out_.push_back(static_cast<std::uint8_t>(bitbuf_ & 0xFFu));
-            bitbuf_ = 0;
-            bitCount_ = 0;
-        }
-    }
+std::size_t tableEntrySize(std::uint8_t version) {
+    return version >= 5 ? 12 : 8;
+}
 
-    std::vector<std::uint8_t> finish() {
-        alignToByte();
-        return std::move(out_);
+bool knownAlgo(std::uint8_t algo) {
+    switch (static_cast<CompAlgo>(algo)) {
+        case CompAlgo::LZW_VAR_ALL:
+        case CompAlgo::LZW_VAR_ALPHA:
+        case CompAlgo::LZ_FAST:
+        case CompAlgo::LZ_HUFF:
+        case CompAlgo::LZW_WIDE:
+        case CompAlgo::STORED:
+        case CompAlgo::LZ_DICT:
+            return true;
+        case CompAlgo::AUTO:
+            return false;
     }
+    return false;
+}
 
-private:
-    std::uint32_t bitbuf_;
-    int bitCount_;
-    std::vector<std::uint8_t> out_;
-};
+bool isLzw(CompAlgo algo) {
+    return algo == CompAlgo::LZW_VAR_ALL || algo == CompAlgo::LZW_VAR_ALPHA || algo == CompAlgo::LZW_WIDE;
+}
 
-class BitReader {
-public:
-    explicit BitReader(const std::vector<std::uint8_t>& data)
-        : data_(data), pos_(0), bitbuf_(0), bitCount_(0) {}
-
-    std::optional<std::uint32_t> get(int nbits) {
-        if (nbits <= 0) return std::optional<std::uint32_t>(0);
-        while (bitCount_ < nbits) {
-            if (pos_ >= data_.size()) return std::nullopt;
-            bitbuf_ |= (std::uint32_t)data_[pos_++] << bitCount_;
-            bitCount_ += 8;
-        }
-        std::uint32_t mask = (nbits == 32 ? 0xFFFFFFFFu : ((1u << nbits) - 1u));
-        std::uint32_t value = bitbuf_ & mask;
-        bitbuf_ >>= nbits;
-        bitCount_ -= nbits;
-        return value;
-    }
+lzw::Params lzwParams(CompAlgo algo) {
+    if (algo == CompAlgo::LZW_WIDE) return lzw::Params{false, true, lzw::kDefaultWideBits};
+    return lzw::Params{algo == CompAlgo::LZW_VAR_ALPHA};
+}
+
+std::size_t blockSizeFor(CompAlgo algo) {
+    return algo == CompAlgo::LZW_WIDE ? kWideBlock : kCompressBlock;
+}
+
+// Сколько блоков на поток в одной партии: больше — ровнее загрузка, но больше памяти.
+// Для крупных блоков партия уменьшается, чтобы держать в памяти примерно тот же объём.
+constexpr std::size_t kBatchPerThread = 4;
 
-    void alignToByte() {
-        bitbuf_ = 0;
-        bitCount_ = 0;
+std::size_t batchPerThread(std::uint64_t blockSize) {
+    return std::max<std::size_t>(1, static_cast<std::size_t>(kBatchPerThread * kCompressBlock / std::max<std::uint64_t>(1, blockSize)));
+}
+
+// Сколько потоков берут блоки: не больше блоков и ядер. Пул общий на процесс —
+// сжатие одного файла не создаёт и не завершает потоки на каждый вызов.
+unsigned workersFor(unsigned threads, std::size_t blocks) {
+    if (threads == 0) threads = ThreadPool::defaultThreads();
+    threads = std::min(threads, ThreadPool::defaultThreads());
+    return static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(threads, blocks)));
+}
+
+// Один поток (в том числе один блок) — цикл прямо здесь, без пула.
+void forEachBlock(std::size_t n, unsigned workers, const ThreadPool::Job& fn) {
+    if (workers <= 1) {
+        for (std::size_t i = 0; i < n; ++i) fn(i, 0);
+        return;
     }
+    ThreadPool::shared().parallelFor(n, fn, workers);
+}
 
-private:
-    const std::vector<std::uint8_t>& data_;
-    std::size_t pos_;
-    std::uint32_t bitbuf_;
-    int bitCount_;
+// Разобранный заголовок контейнера; v3 описывается как один блок на весь файл.
+struct Layout {
+    std::uint8_t version{0};
+    CompAlgo algo{CompAlgo::LZW_VAR_ALL};
+    std::uint64_t origSize{0};
+    std::uint64_t blockSize{0};
+    std::uint32_t dictId{0};            // LZ_DICT
+    std::size_t tableStart{0};
+    std::size_t dataStart{0};
+    std::vector<std::uint64_t> ends;    // смещение конца каждого блока в файле
+    std::vector<bool> stored;           // блок лежит как есть (не сжался)
+    std::vector<std::uint32_t> crcs;    // CRC32C исходных байт блока; пусто до v5
 };
 
-// ======= Общие константы LZW (переменная разрядность) =======
-
-int LZW_MIN_BITS() { return 9; }
-int LZW_MAX_BITS() { return 16; }
-std::uint32_t LZW_FIRST_FREE() { return 256u; }
-std::uint32_t LZW_DICT_LIMIT() { return 1u << LZW_MAX_BITS(); }
+// Поля v4/v5 после фиксированной части: у LZ_DICT — id словаря.
+std::size_t headerExtra(CompAlgo algo) {
+    return algo == CompAlgo::LZ_DICT ? 4 : 0;
+}
 
-// ======= Вспомогательная проверка «буквенности» ASCII-байта =======
+// Старший бит конца блока в таблице: блок не сжался и хранится как есть.
+constexpr std::uint64_t kStoredBlock = std::uint64_t{1} << 63;
 
-bool is_ascii_letter(std::uint8_t b) {
-    return (b >= 'A' && b <= 'Z') || (b >= 'a' && b <= 'z');
+Layout parseLayout(const FileContent& f) {
+    if (f.size() < kHeaderSizeV3) throw VfsException(ErrorCode::InvalidArg);
+    auto b = f.read(0, kHeaderSizeV3);
+    if (b[0] != 'C' || b[1] != 'M' || b[2] != 'P') throw VfsException(ErrorCode::InvalidArg);
+    if (!knownVersion(b[3])) throw VfsException(ErrorCode::Unsupported);
+    if (!knownAlgo(b[4])) throw VfsException(ErrorCode::Unsupported);
+    Layout l;
+    l.version = b[3];
+    l.algo = static_cast<CompAlgo>(b[4]);
+    l.origSize = get64(&b[5]);
+
+    if (b[3] == 3) {
+        // v3 существовал только для LZW
+        if (!isLzw(l.algo)) throw VfsException(ErrorCode::Unsupported);
+        l.blockSize = l.origSize;
+        l.dataStart = kHeaderSizeV3;
+        l.ends.push_back(f.size());
+        l.stored.push_back(false);
+        return l;
+    }
+    l.tableStart = kHeaderSizeV4 + headerExtra(l.algo);
+    if (f.size() < l.tableStart) throw VfsException(ErrorCode::Corrupted);
+    auto h = f.read(kHeaderSizeV3, l.tableStart - kHeaderSizeV3);
+    const std::size_t entry = tableEntrySize(b[3]);
+    l.blockSize = get32(&h[0]);
+    const std::uint64_t blocks = get32(&h[4]);
+    if (l.algo == CompAlgo::LZ_DICT) l.dictId = get32(&h[8]);
+    // размер блока — степень двойки, число блоков следует из размеров
+    if (l.blockSize == 0 || (l.blockSize & (l.blockSize - 1)) != 0 ||
+        blocks != (l.origSize + l.blockSize - 1) / l.blockSize ||
+        blocks > (f.size() - l.tableStart) / entry) {
+        throw VfsException(ErrorCode::Corrupted);
+    }
+    l.dataStart = l.tableStart + static_cast<std::size_t>(entry * blocks);
+    auto table = f.read(l.tableStart, static_cast<std::size_t>(entry * blocks));
+    l.ends.resize(static_cast<std::size_t>(blocks));
+    l.stored.resize(static_cast<std::size_t>(blocks));
+    if (b[3] >= 5) l.crcs.resize(static_cast<std::size_t>(blocks));
+    std::uint64_t prev = l.dataStart;
+    for (std::size_t i = 0; i < l.ends.size(); ++i) {
+        const std::uint64_t end = get64(&table[entry * i]);
+        l.stored[i] = (end & kStoredBlock) != 0;
+        l.ends[i] = end & ~kStoredBlock;
+        if (!l.crcs.empty()) l.crcs[i] = get32(&table[entry * i + 8]);
+        if (l.ends[i] < prev) throw VfsException(ErrorCode::Corrupted);
+        prev = l.ends[i];
+    }
+    if (prev != f.size()) throw VfsException(ErrorCode::Corrupted);
+    return l;
 }
 
-// ======= LZW: универсальная кодировка (ALL/ALPHA управляется политикой добавления) =======
+DictionaryPtr findDictionary(const Layout& l, const DictionaryLookup& dicts) {
+    if (l.algo != CompAlgo::LZ_DICT) return nullptr;
+    DictionaryPtr d = dicts ? dicts(l.dictId) : nullptr;
+    if (!d) throw VfsException(ErrorCode::NotFound);
+    if (d->id != l.dictId) throw VfsException(ErrorCode::Corrupted);
+    return d;
+}
 
-std::vector<std::uint8_t> lzw_varwidth_compress_generic(
-        const std::vector<std::uint8_t>& input,
-        bool alpha_only_dictionary)
-{
-    BitWriter writer;
-    if (input.empty()) return writer.finish();
+// Распакованный блок сверяется с CRC32C из таблицы v5.
+void verifyBlock(const std::vector<std::uint32_t>& crcs, std::size_t idx, std::span<const std::uint8_t> plain) {
+    if (!crcs.empty() && crc32c::compute(plain) != crcs[idx]) throw VfsException(ErrorCode::Corrupted);
+}
 
-    // Словарь: строка байтов -> код
-    std::unordered_map<std::string, std::uint32_t> dict;
-    dict.reserve(1 << 15);
-    for (int i = 0; i < 256; ++i) {
-        std::string s(1, static_cast<char>(i));
-        dict.emplace(std::move(s), (std::uint32_t)i);
+// CRC32C исходных байт [begin, end) файла.
+std::uint32_t rangeCrc(const FileContent& f, std::size_t begin, std::size_t end) {
+    std::uint32_t crc = 0;
+    for (std::size_t pos = begin; pos < end; ) {
+        auto piece = f.view(pos, end - pos);
+        crc = crc32c::extend(crc, piece);
+        pos += piece.size();
     }
+    return crc;
+}
 
-    std::string w;
-    w.push_back(static_cast<char>(input[0]));
+// Блок как есть: [begin, end) файла дописывается в out.
+void appendRaw(const FileContent& f, std::size_t begin, std::size_t end, std::vector<std::uint8_t>& out) {
+    const std::size_t base = out.size();
+    out.resize(base + (end - begin));
+    f.readInto(begin, std::span<std::uint8_t>(out.data() + base, end - begin));
+}
 
-    std::uint32_t nextCode = LZW_FIRST_FREE();
-    int codeBits = LZW_MIN_BITS();
+// Предпроверка: энтропия байтов по началу файла. Порог близок к 8 бит/байт —
+// так выглядят уже сжатые и зашифрованные данные; на коротком префиксе оценка
+// занижена, поэтому мелкие файлы не проверяются.
+constexpr std::size_t kEntropyPrefix = 64 * 1024;
+constexpr std::size_t kEntropyMinPrefix = 4 * 1024;
+constexpr double kIncompressibleBits = 7.9;
 
-    for (std::size_t i = 1; i < input.size(); ++i) {
-        char c = static_cast<char>(input[i]);
-        std::string wc = w;
-        wc.push_back(c);
+} // namespace
 
-        auto it = dict.find(wc);
-        if (it != dict.end()) {
-            // Фраза расширяется
-            w = std::move(wc);
-            continue;
-        }
 
-        // Выводим код текущей фразы
-        std::uint32_t code = dict.at(w);
-        writer.put(code, codeBits);
-
-// Политика добавления в словарь:
-        // ALL: добавляем всегда, пока есть место;
-        // ALPHA: добавляем ТОЛЬКО если и w, и c состоят из буквенных ASCII.
-        bool can_add = (nextCode < LZW_DICT_LIMIT());
-        if (can_add) {
-            bool allow = true;
-            if (alpha_only_dictionary) {
-                // проверим, что все байты в wc — «буквы»
-                for (char ch : wc) {
-                    if (!is_ascii_letter(static_cast<std::uint8_t>(ch))) {
-                        allow = false;
-                        break;
-                    }
-                }
+// Рабочее состояние кодека одного потока: словари и таблицы переиспользуются
+// от блока к блоку.
+class BlockCodec {
+public:
+    // Словарь нужен только LZ_DICT: у остальных в заголовке нет его id, и
+    // распаковка без словаря не поймёт ссылки в него.
+    explicit BlockCodec(CompAlgo algo, DictionaryPtr dict = nullptr)
+        : algo_(algo), dict_(algo == CompAlgo::LZ_DICT ? std::move(dict) : nullptr) {
+        if (algo_ == CompAlgo::LZ_DICT && !dict_) throw VfsException(ErrorCode::InvalidArg);
+    }
+
+    // Сжатый блок [begin, end) файла дописывается в out.
+    void encode(const FileContent& f, std::size_t begin, std::size_t end, std::vector<std::uint8_t>& out) {
+        if (isLzw(algo_)) {
+            auto& enc = lzwEncoder();
+            for (std::size_t pos = begin; pos < end; ) {
+                auto piece = f.view(pos, std::min(kStreamChunk, end - pos));
+                enc.feed(piece, out);
+                pos += piece.size();
             }
-            if (allow) {
-                // перед добавлением проверяем, не требуется ли увеличить разрядность
-                if (nextCode == (1u << codeBits) && codeBits < LZW_MAX_BITS()) {
-                    ++codeBits;
-                    writer.alignToByte();
-                }
-                dict.emplace(std::move(wc), nextCode++);
+            enc.finish(out);
+            return;
+        }
+        if (algo_ == CompAlgo::STORED) {
+            appendRaw(f, begin, end, out);
+        } else if (algo_ == CompAlgo::LZ_HUFF) {
+            huff_.compress(contiguous(f, begin, end), out);
+        } else {
+            fast_.compress(contiguous(f, begin, end), out, dictBytes());
+        }
+    }
+
+    // Сжатый блок [begin, end) файла распаковывается в out ровно в expected байт.
+    // stored — блок не сжался и лежит как есть, кодек не нужен.
+    void decode(const FileContent& f, std::size_t begin, std::size_t end, std::uint64_t expected,
+                std::vector<std::uint8_t>& out, bool stored = false) {
+        if (stored || algo_ == CompAlgo::STORED) {
+            if (end - begin != expected) throw VfsException(ErrorCode::Corrupted);
+            appendRaw(f, begin, end, out);
+            return;
+        }
+        if (isLzw(algo_)) {
+            auto& dec = lzwDecoder();
+            const std::size_t base = out.size();
+            out.reserve(base + static_cast<std::size_t>(expected));
+            for (std::size_t pos = begin; pos < end; ) {
+                auto piece = f.view(pos, std::min(kStreamChunk, end - pos));
+                dec.feed(piece, out);
+                pos += piece.size();
+                if (out.size() - base > expected) throw VfsException(ErrorCode::Corrupted);
             }
+            dec.finish();
+            if (out.size() - base != expected) throw VfsException(ErrorCode::Corrupted);
+            return;
+        }
+        if (algo_ == CompAlgo::LZ_HUFF) {
+            lzhuff::decompress(contiguous(f, begin, end), static_cast<std::size_t>(expected), out);
+        } else {
+            lzfast::decompress(contiguous(f, begin, end), static_cast<std::size_t>(expected), out, dictBytes());
         }
+    }
 
-        // Если ALPHA и текущий символ «не буква», разорвать фразу,
-        // т.е. w = текущий символ; иначе обычное правило
-        w.assign(1, c);
+private:
+    lzw::Decoder& lzwDecoder() {
+        if (lzwDec_) lzwDec_->reset();
+        else lzwDec_ = std::make_unique<lzw::Decoder>(lzwParams(algo_));
+        return *lzwDec_;
+    }
+    lzw::Encoder& lzwEncoder() {
+        if (lzwEnc_) lzwEnc_->reset();
+        else lzwEnc_ = std::make_unique<lzw::Encoder>(lzwParams(algo_));
+        return *lzwEnc_;
     }
 
-    // финальный код
-    std::uint32_t finalCode = dict.at(w);
-    writer.put(finalCode, codeBits);
+    // Кодекам, которым нужен непрерывный вход: внутри одной страницы — без копии.
+    std::span<const std::uint8_t> contiguous(const FileContent& f, std::size_t begin, std::size_t end) {
+        auto view = f.view(begin, end - begin);
+        if (view.size() == end - begin) return view;
+        scratch_.resize(end - begin);
+        f.readInto(begin, scratch_);
+        return scratch_;
+    }
 
-    return writer.finish();
-}
+    std::span<const std::uint8_t> dictBytes() const noexcept {
+        return dict_ ? std::span<const std::uint8_t>(dict_->bytes) : std::span<const std::uint8_t>();
+    }
 
-std::vector<std::uint8_t> lzw_varwidth_decompress_generic(
-        const std::vector<std::uint8_t>& payload,
-        bool alpha_only_dictionary)
-{
-    if (payload.empty()) return {};
+    CompAlgo algo_;
+    DictionaryPtr dict_;
+    std::unique_ptr<lzw::Encoder> lzwEnc_;
+    std::unique_ptr<lzw::Decoder> lzwDec_;
+    lzfast::Compressor fast_;
+    lzhuff::Compressor huff_;
+    std::vector<std::uint8_t> scratch_;
+};
 
-    BitReader reader(payload);
+std::uint32_t dictionaryId(std::span<const std::uint8_t> bytes) {
+    std::uint32_t h = 2166136261u;
+    for (std::uint8_t b : bytes) h = (h ^ b) * 16777619u;
+    return h ? h : 1;
+}
 
-    // Первый код всегда читается на мин.разрядности
-    auto firstCodeOpt = reader.get(LZW_MIN_BITS());
-    if (!firstCodeOpt) throw VfsException(ErrorCode::Corrupted);
-    std::uint32_t first = *firstCodeOpt;
-    if (first >= 256u) throw VfsException(ErrorCode::Corrupted);
+DictionaryPtr makeDictionary(std::vector<std::uint8_t> bytes) {
+    if (bytes.size() > kMaxDictionary) throw VfsException(ErrorCode::InvalidArg);
+    auto d = std::make_shared<SharedDictionary>();
+    d->id = dictionaryId(bytes);
+    d->bytes = std::move(bytes);
+    return d;
+}
 
-    // Словарь: код -> строка байтов
-    std::vector<std::string> dict;
-    dict.reserve(LZW_DICT_LIMIT());
-    for (int i = 0; i < 256; ++i) dict.emplace_back(1, static_cast<char>(i));
+bool isCompressed(const FileContent& f) {
+    if (f.size() < kHeaderSizeV3) return false;
+    auto b = f.read(0, kHeaderSizeV3);
+    if (b[0] != 'C' || b[1] != 'M' || b[2] != 'P') return false;
+    if (!knownVersion(b[3])) return false;
+    return knownAlgo(b[4]);
+}
 
-    std::string prev = dict[first];
-    std::vector<std::uint8_t> out(prev.begin(), prev.end());
+namespace {
 
-    std::uint32_t nextCode = LZW_FIRST_FREE();
-    int codeBits = LZW_MIN_BITS();
+// compress auto: до kAutoSamples кусков по kAutoSampleBytes, равномерно по файлу;
+// файл не длиннее всех кусков вместе пробуется целиком.
+constexpr std::size_t kAutoSamples = 4;
+constexpr std::size_t kAutoSampleBytes = 64 * 1024;
 
-    while (true) {
-        auto codeOpt = reader.get(codeBits);
-        if (!codeOpt) break;
-        std::uint32_t code = *codeOpt;
+struct AutoCandidate {
+    CompAlgo algo;
+    double secondsPerMiB;   // сжатие + распаковка, один поток (bench-codecs)
+};
 
-        std::string entry;
-        if (code < dict.size()) {
-            entry = dict[code];
-        } else if (code == nextCode && !prev.empty()) {
-            // «Квирк» LZW: K = prev + first(prev)
-            entry = prev;
-            entry.push_back(prev.front());
-        } else {
-            throw VfsException(ErrorCode::Corrupted);
-        }
+// LZW_WIDE не участвует: он выигрывает, только когда словарь заполняется на
+// мегабайтах, а на пробных кусках неотличим от ALL и лишь дороже.
+constexpr AutoCandidate kAutoCandidates[] = {
+    {CompAlgo::LZ_FAST, 0.012},
+    {CompAlgo::LZ_HUFF, 0.025},
+    {CompAlgo::LZW_VAR_ALL, 0.025},
+    {CompAlgo::LZW_VAR_ALPHA, 0.028},
+};
 
-        out.insert(out.end(), entry.begin(), entry.end());
-
-        // Политика добавления в словарь в декодере должна зеркалить энкодер
-        bool can_add = (nextCode < LZW_DICT_LIMIT());
-        if (can_add) {
-            bool allow = true;
-            if (alpha_only_dictionary) {
-                // добавляем prev + first(entry) только если все байты «буквы»
-                std::string newEntry = prev;
-                if (!entry.empty()) newEntry.push_back(entry.front());
-                for (char ch : newEntry) {
-                    if (!is_ascii_letter(static_cast<std::uint8_t>(ch))) {
-                        allow = false;
-                        break;
-                    }
-                }
-                if (allow) {
-                    if (nextCode == (1u << codeBits) && codeBits < LZW_MAX_BITS()) {
-                        ++codeBits;
-                        reader.alignToByte();
-                    }
-                    dict.push_back(std::move(newEntry));
-                    ++nextCode;
-                }
-            } else {
-                // ALL
-                if (!prev.empty() && !entry.empty()) {
-                    std::string newEntry = prev;
-                    newEntry.push_back(entry.front());
-
-if (nextCode == (1u << codeBits) && codeBits < LZW_MAX_BITS()) {
-                        ++codeBits;
-                        reader.alignToByte();
-                    }
-                    dict.push_back(std::move(newEntry));
-                    ++nextCode;
-                }
+// Сжимает src блоками по blockSize и дописывает их в out (out уже содержит всё,
+// что лежит перед ними в файле); в table — записи этих блоков: конец с флагом
+// несжатого блока и CRC32C.
+// Блоки сжимаются параллельно партиями по несколько на поток и дописываются
+// строго по порядку, поэтому результат не зависит от числа потоков.
+// Целиком в памяти не лежат ни вход, ни выход — только текущая партия.
+void packBlocks(const FileContent& src, CompAlgo algo, const DictionaryPtr& dict, unsigned threads,
+                std::size_t blockSize, FileContent& out, std::vector<std::uint8_t>& table) {
+    const std::size_t size = src.size();
+    const std::size_t blocks = (size + blockSize - 1) / blockSize;
+    table.reserve(table.size() + tableEntrySize(kVersion) * blocks);
+    const unsigned workers = workersFor(threads, blocks);
+    std::vector<std::unique_ptr<BlockCodec>> codecs(workers);
+    std::vector<std::vector<std::uint8_t>> packed(workers * batchPerThread(blockSize));
+    std::vector<std::uint8_t> raw(packed.size());
+    std::vector<std::uint32_t> crcs(packed.size());
+    for (std::size_t first = 0; first < blocks; first += packed.size()) {
+        const std::size_t count = std::min(packed.size(), blocks - first);
+        forEachBlock(count, workers, [&](std::size_t i, unsigned worker) {
+            auto& codec = codecs[worker];
+            if (!codec) codec = std::make_unique<BlockCodec>(algo, dict);
+            const std::size_t begin = (first + i) * blockSize;
+            const std::size_t end = std::min(size, begin + blockSize);
+            crcs[i] = rangeCrc(src, begin, end);
+            packed[i].clear();
+            codec->encode(src, begin, end, packed[i]);
+            // не сжалось — блок остаётся как есть, распаковка его просто скопирует
+            raw[i] = algo != CompAlgo::STORED && packed[i].size() >= end - begin;
+            if (raw[i]) {
+                packed[i].clear();
+                appendRaw(src, begin, end, packed[i]);
             }
+        });
+        for (std::size_t i = 0; i < count; ++i) {
+            out.append(packed[i]);
+            put64(table, out.size() | (raw[i] ? kStoredBlock : 0));
+            put32(table, crcs[i]);
         }
-
-        prev = std::move(entry);
     }
-
-    return out;
 }
 
-// Конкретные «обёртки» двух режимов
+} // namespace
 
-std::vector<std::uint8_t> lzw_var_all_compress(const std::vector<std::uint8_t>& input) {
-    return lzw_varwidth_compress_generic(input, /*alpha_only_dictionary=*/false);
-}
-std::vector<std::uint8_t> lzw_var_alpha_compress(const std::vector<std::uint8_t>& input) {
-    return lzw_varwidth_compress_generic(input, /*alpha_only_dictionary=*/true);
-}
-std::vector<std::uint8_t> lzw_var_all_decompress(const std::vector<std::uint8_t>& payload) {
-    return lzw_varwidth_decompress_generic(payload, /*alpha_only_dictionary=*/false);
-}
-std::vector<std::uint8_t> lzw_var_alpha_decompress(const std::vector<std::uint8_t>& payload) {
-    return lzw_varwidth_decompress_generic(payload, /*alpha_only_dictionary=*/true);
+bool looksIncompressible(const FileContent& f) {
+    const std::size_t n = std::min(f.size(), kEntropyPrefix);
+    if (n < kEntropyMinPrefix) return false;
+    std::array<std::uint32_t, 256> freq{};
+    for (std::size_t pos = 0; pos < n; ) {
+        auto piece = f.view(pos, n - pos);
+        for (std::uint8_t b : piece) ++freq[b];
+        pos += piece.size();
+    }
+    double bits = 0;
+    for (std::uint32_t c : freq) {
+        if (!c) continue;
+        const double p = static_cast<double>(c) / static_cast<double>(n);
+        bits -= p * std::log2(p);
+    }
+    return bits >= kIncompressibleBits;
 }
 
-} // namespace
-
+CompAlgo chooseAlgo(const FileContent& f, const AutoObjective& objective, const DictionaryPtr& dict) {
+    if (looksIncompressible(f)) return CompAlgo::STORED;
+    const std::size_t size = f.size();
+    std::vector<std::pair<std::size_t, std::size_t>> samples;
+    if (size <= kAutoSamples * kAutoSampleBytes) {
+        if (size) samples.emplace_back(0, size);
+    } else {
+        for (std::size_t i = 0; i < kAutoSamples; ++i) {
+            const std::size_t begin = (size - kAutoSampleBytes) / (kAutoSamples - 1) * i;
+            samples.emplace_back(begin, begin + kAutoSampleBytes);
+        }
+    }
 
-bool isCompressed(const FileContent& f) {
-    const std::vector<std::uint8_t>& b = f.bytes();
-    if (b.size() < 13) return false;
-    if (b[0] != 'C' || b[1] != 'M' || b[2] != 'P') return false;
-    if (b[3] != 3) return false;
-    std::uint8_t algo = b[4];
-    return algo == static_cast<std::uint8_t>(CompAlgo::LZW_VAR_ALL) ||
-           algo == static_cast<std::uint8_t>(CompAlgo::LZW_VAR_ALPHA);
+    // STORED ничего не стоит и ничего не даёт: доля 1.0
+    CompAlgo best = CompAlgo::STORED;
+    double bestCost = 1.0;
+    std::vector<AutoCandidate> candidates(std::begin(kAutoCandidates), std::end(kAutoCandidates));
+    // LZ_DICT по скорости — тот же LZ_FAST
+    if (dict) candidates.push_back({CompAlgo::LZ_DICT, kAutoCandidates[0].secondsPerMiB});
+    std::vector<std::uint8_t> packed;
+    for (const auto& c : candidates) {
+        BlockCodec codec(c.algo, dict);
+        std::size_t raw = 0, out = 0;
+        for (auto [begin, end] : samples) {
+            packed.clear();
+            codec.encode(f, begin, end, packed);
+            raw += end - begin;
+            out += packed.size();
+        }
+        if (!raw) break;
+        const double cost = static_cast<double>(out) / static_cast<double>(raw) + objective.speedWeight * c.secondsPerMiB;
+        if (cost < bestCost) {
+            best = c.algo;
+            bestCost = cost;
+        }
+    }
+    return best;
 }
 
-void compressInplace(FileContent& f, CompAlgo algo) {
+void compressInplace(FileContent& f, CompAlgo algo, unsigned threads, const AutoObjective& objective,
+                     const DictionaryPtr& dict) {
     if (isCompressed(f)) return;
+    if (algo == CompAlgo::AUTO) algo = chooseAlgo(f, objective, dict);
+    if (algo == CompAlgo::LZ_DICT && !dict) throw VfsException(ErrorCode::InvalidArg);
+    // уже сжатые данные не гоняем через кодек: всё равно не уменьшатся
+    if (algo != CompAlgo::STORED && looksIncompressible(f)) algo = CompAlgo::STORED;
+
+    if (!knownAlgo(static_cast<std::uint8_t>(algo))) throw VfsException(ErrorCode::Unsupported);
+    const std::uint64_t size = f.size();
+    const std::size_t blockSize = blockSizeFor(algo);
+    const std::size_t blocks = static_cast<std::size_t>((size + blockSize - 1) / blockSize);
+    std::vector<std::uint8_t> header;
+    header.push_back('C'); header.push_back('M'); header.push_back('P');
+    header.push_back(kVersion);
+    header.push_back(static_cast<std::uint8_t>(algo));
+    put64(header, size);
+    put32(header, static_cast<std::uint32_t>(blockSize));
+    put32(header, static_cast<std::uint32_t>(blocks));
+    if (algo == CompAlgo::LZ_DICT) put32(header, dict->id);
+    const std::size_t tableStart = header.size();
+    // место под таблицу; заполняется, когда размеры блоков станут известны
+    header.resize(header.size() + tableEntrySize(kVersion) * blocks, 0);
+
+    FileContent out;
+    out.append(header);
+    std::vector<std::uint8_t> table;
+    packBlocks(f, algo, dict, threads, blockSize, out, table);
+    out.write(tableStart, table);
+    f = std::move(out);
+}
 
-    const std::vector<std::uint8_t>& raw = f.bytes();
+bool appendCompressed(FileContent& f, std::span<const std::uint8_t> data, unsigned threads,
+                      const DictionaryLookup& dicts) {
+    const Layout layout = parseLayout(f);
+    // у v3/v4 нет контрольных сумм нетронутых блоков — такой файл сжимается заново целиком
+    if (layout.version < kVersion) return false;
+    if (data.empty()) return true;
+    const DictionaryPtr dict = findDictionary(layout, dicts);
+    const std::size_t blockSize = static_cast<std::size_t>(layout.blockSize);
+    const std::size_t oldBlocks = layout.ends.size();
+    // полные блоки остаются как есть, неполный последний распаковывается и дополняется
+    const std::size_t keep = static_cast<std::size_t>(layout.origSize / blockSize);
+    const std::size_t tailBegin = keep == 0 ? layout.dataStart : static_cast<std::size_t>(layout.ends[keep - 1]);
+    FileContent tail;
+    if (keep < oldBlocks) {
+        std::vector<std::uint8_t> plain;
+        BlockCodec codec(layout.algo, dict);
+        codec.decode(f, tailBegin, static_cast<std::size_t>(layout.ends[keep]), layout.origSize - keep * blockSize,
+                     plain, layout.stored[keep]);
+        verifyBlock(layout.crcs, keep, plain);
+        tail.replaceAll(std::move(plain));
+    }
+    tail.append(data);
+
+    const std::uint64_t size = layout.origSize + data.size();
+    const std::size_t blocks = keep + (tail.size() + blockSize - 1) / blockSize;
+    const std::size_t entry = tableEntrySize(kVersion);
+    const std::size_t shift = entry * (blocks - oldBlocks);
+    std::vector<std::uint8_t> table;
+    if (shift == 0) {
+        // таблица не растёт: переписываются только последний блок и его запись
+        f.truncate(tailBegin);
+        packBlocks(tail, layout.algo, dict, threads, blockSize, f, table);
+    } else {
+        // Таблица растёт, и сжатые байты нетронутых блоков сдвигаются вслед за ней —
+        // копированием, без перекодирования; это бывает раз на blockSize дописанных байт.
+        FileContent out;
+        out.append(f.read(0, layout.tableStart));
+        std::vector<std::uint8_t> kept;
+        kept.reserve(entry * blocks);
+        for (std::size_t i = 0; i < keep; ++i) {
+            put64(kept, (layout.ends[i] + shift) | (layout.stored[i] ? kStoredBlock : 0));
+            put32(kept, layout.crcs[i]);
+        }
+        kept.resize(entry * blocks, 0);
+        out.append(kept);
+        for (std::size_t pos = layout.dataStart; pos < tailBegin; ) {
+            auto piece = f.view(pos, tailBegin - pos);
+            out.append(piece);
+            pos += piece.size();
+        }
+        packBlocks(tail, layout.algo, dict, threads, blockSize, out, table);
+        f = std::move(out);
+        std::vector<std::uint8_t> count;
+        put32(count, static_cast<std::uint32_t>(blocks));
+        f.write(kHeaderSizeV3 + 4, count);
+    }
+    std::vector<std::uint8_t> sizeField;
+    put64(sizeField, size);
+    f.write(5, sizeField);
+    f.write(layout.tableStart + entry * keep, table);
+    return true;
+}
 
-    std::vector<std::uint8_t> hdr;
-    hdr.push_back('C'); hdr.push_back('M'); hdr.push_back('P');
-    hdr.push_back(3);
-    hdr.push_back(static_cast<std::uint8_t>(algo));
-    put64(hdr, static_cast<std::uint64_t>(raw.size()));
+void uncompressInplace(FileContent& f, unsigned threads, const DictionaryLookup& dicts) {
+    const Layout layout = parseLayout(f);
+    const DictionaryPtr dict = findDictionary(layout, dicts);
+    FileContent out;
+    if (layout.ends.size() <= 1) {
+        // один блок (в том числе v3) — потоковая распаковка без буфера на весь файл
+        DecompressReader reader(f, dicts);
+        std::vector<std::uint8_t> chunk(kStreamChunk);
+        while (std::size_t n = reader.read(chunk)) {
+            out.append(std::span<const std::uint8_t>(chunk.data(), n));
+        }
+        f = std::move(out);
+        return;
+    }
 
-    std::vector<std::uint8_t> payload;
-    switch (algo) {
-        case CompAlgo::LZW_VAR_ALL:
-            payload = lzw_var_all_compress(raw);
-            break;
-        case CompAlgo::LZW_VAR_ALPHA:
-            payload = lzw_var_alpha_compress(raw);
-            break;
-        default:
-            throw VfsException(ErrorCode::Unsupported);
+    const std::size_t blocks = layout.ends.size();
+    const unsigned workers = workersFor(threads, blocks);
+    std::vector<std::unique_ptr<BlockCodec>> codecs(workers);
+    std::vector<std::vector<std::uint8_t>> plain(workers * batchPerThread(layout.blockSize));
+    for (std::size_t first = 0; first < blocks; first += plain.size()) {
+        const std::size_t count = std::min(plain.size(), blocks - first);
+        forEachBlock(count, workers, [&](std::size_t i, unsigned worker) {
+            auto& codec = codecs[worker];
+            if (!codec) codec = std::make_unique<BlockCodec>(layout.algo, dict);
+            const std::size_t idx = first + i;
+            const std::size_t begin = idx == 0 ? layout.dataStart : static_cast<std::size_t>(layout.ends[idx - 1]);
+            const std::uint64_t expected =
+                std::min(layout.origSize, (idx + 1) * layout.blockSize) - idx * layout.blockSize;
+            plain[i].clear();
+            codec->decode(f, begin, static_cast<std::size_t>(layout.ends[idx]), expected, plain[i], layout.stored[idx]);
+            verifyBlock(layout.crcs, idx, plain[i]);
+        });
+        for (std::size_t i = 0; i < count; ++i) out.append(plain[i]);
     }
+    f = std::move(out);
+}
 
-    std::vector<std::uint8_t> out;
-    out.reserve(hdr.size() + payload.size());
-    out.insert(out.end(), hdr.begin(), hdr.end());
-    out.insert(out.end(), payload.begin(), payload.end());
-    f.replaceAll(out);
+std::size_t readDecompressed(const FileContent& f, std::uint64_t off, std::span<std::uint8_t> dst,
+                             const DictionaryLookup& dicts) {
+    DecompressReader reader(f, dicts);
+    reader.seek(off);
+    return reader.read(dst);
 }
 
-void uncompressInplace(FileContent& f) {
-    const std::vector<std::uint8_t>& b = f.bytes();
-    if (b.size() < 13) throw VfsException(ErrorCode::InvalidArg);
-    if (b[0] != 'C' || b[1] != 'M' || b[2] != 'P') throw VfsException(ErrorCode::InvalidArg);
-    if (b[3] != 3) throw VfsException(ErrorCode::Unsupported);
+DecompressReader::DecompressReader(const FileContent& f, const DictionaryLookup& dicts) : file_(f) {
+    Layout layout = parseLayout(f);
+    codec_ = std::make_unique<BlockCodec>(layout.algo, findDictionary(layout, dicts));
+    if (isLzw(layout.algo) && layout.crcs.empty()) decoder_ = std::make_unique<lzw::Decoder>(lzwParams(layout.algo));
+    origSize_ = layout.origSize;
+    blockSize_ = layout.blockSize;
+    dataStart_ = layout.dataStart;
+    ends_ = std::move(layout.ends);
+    stored_ = std::move(layout.stored);
+    crcs_ = std::move(layout.crcs);
+    // Буфер вывода переиспользуется между порциями; ёмкость берём сразу по размеру
+    // блока (но не больше окна с запасом), чтобы декодер его не перевыделял.
+    pending_.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(blockSize_, 3 * kHistory)));
+    if (!ends_.empty()) startBlock(0);
+}
 
-    CompAlgo algo = static_cast<CompAlgo>(b[4]);
-    std::uint64_t origSize = get64(&b[5]);
+DecompressReader::~DecompressReader() = default;
 
-    std::vector<std::uint8_t> payload(b.begin() + 13, b.end());
-    std::vector<std::uint8_t> raw;
+void DecompressReader::startBlock(std::size_t idx) {
+    block_ = idx;
+    srcPos_ = idx == 0 ? dataStart_ : static_cast<std::size_t>(ends_[idx - 1]);
+    srcEnd_ = static_cast<std::size_t>(ends_[idx]);
+    produced_ = idx * blockSize_;
+    if (decoder_) decoder_->reset();
+    pending_.clear();
+    pendingPos_ = 0;
+}
 
-    switch (algo) {
-        case CompAlgo::LZW_VAR_ALL:
-            raw = lzw_var_all_decompress(payload);
-            break;
-        case CompAlgo::LZW_VAR_ALPHA:
-            raw = lzw_var_alpha_decompress(payload);
+void DecompressReader::refill() {
+    // Уже выданный хвост остаётся окном истории: декодер копирует из него
+    // повторяющиеся фразы вместо обхода цепочки префиксов. Окно ограничено.
+    if (pending_.size() > 2 * kHistory) {
+        std::size_t drop = pending_.size() - kHistory;
+        pending_.erase(pending_.begin(), pending_.begin() + static_cast<long>(drop));
+        pendingPos_ -= drop;
+    }
+    std::size_t before = pending_.size();
+    // Небольшие порции входа: вывод на порцию ограничен, даже для хорошо сжатых данных.
+    constexpr std::size_t kSourceStep = 4096;
+    while (pending_.size() == before && block_ < ends_.size()) {
+        if (srcPos_ < srcEnd_ && (!decoder_ || stored_[block_])) {
+            // блочный кодек, несжатый блок или v5: целиком (на его начале pending_ пуст)
+            const std::size_t base = pending_.size();
+            codec_->decode(file_, srcPos_, srcEnd_, blockEnd(block_) - produced_, pending_, stored_[block_]);
+            verifyBlock(crcs_, block_, std::span<const std::uint8_t>(pending_).subspan(base));
+            produced_ = blockEnd(block_);
+            srcPos_ = srcEnd_;
+            continue;
+        }
+        if (srcPos_ < srcEnd_) {
+            auto piece = file_.view(srcPos_, std::min(kSourceStep, srcEnd_ - srcPos_));
+            const std::size_t had = pending_.size();
+            decoder_->feed(piece, pending_);
+            srcPos_ += piece.size();
+            produced_ += pending_.size() - had;
+            if (produced_ > blockEnd(block_)) throw VfsException(ErrorCode::Corrupted);
+            continue;
+        }
+        // блок кончился: его вывод должен совпасть с длиной из заголовка
+        if (decoder_) decoder_->finish();
+        if (produced_ != blockEnd(block_)) throw VfsException(ErrorCode::Corrupted);
+        if (block_ + 1 == ends_.size()) {
+            block_ = ends_.size();
             break;
-        default:
-            throw VfsException(ErrorCode::Unsupported);
+        }
+        // всё выданное уже прочитано (refill зовут на пустом буфере) — окно сбрасываем
+        startBlock(block_ + 1);
+        before = 0;
     }
+}
 
-    if (raw.size() != origSize) throw VfsException(ErrorCode::Corrupted);
-    f.replaceAll(raw);
-}
\ No newline at end of file
+std::size_t DecompressReader::read(std::span<std::uint8_t> dst) {
+    std::size_t total = 0;
+    while (total < dst.size()) {
+        if (pendingPos_ == pending_.size()) {
+            refill();
+            if (pendingPos_ == pending_.size()) break;
+        }
+        std::size_t n = std::min(dst.size() - total, pending_.size() - pendingPos_);
+        std::memcpy(dst.data() + total, pending_.data() + pendingPos_, n);
+        pendingPos_ += n;
+        total += n;
+    }
+    return total;
+}
+
+void DecompressReader::skip(std::uint64_t n) {
+    while (n > 0) {
+        if (pendingPos_ == pending_.size()) {
+            refill();
+            if (pendingPos_ == pending_.size()) break;
+        }
+        std::size_t step = static_cast<std::size_t>(std::min<std::uint64_t>(n, pending_.size() - pendingPos_));
+        pendingPos_ += step;
+        n -= step;
+    }
+}
+
+void DecompressReader::seek(std::uint64_t pos) {
+    if (ends_.empty()) return;
+    pos = std::min(pos, origSize_);
+    const std::size_t target = blockSize_ == 0
+        ? 0 : static_cast<std::size_t>(std::min<std::uint64_t>(pos / blockSize_, ends_.size() - 1));
+    // вперёд внутри текущего блока — просто дочитываем, иначе блок заново
+    if (target != block_ || pos < tell()) startBlock(target);
+    skip(pos - tell());
+}
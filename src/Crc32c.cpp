@@ -0,0 +1,103 @@
+#include "Crc32c.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CRC32C_X86 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32C_ARM 1
+#endif
+
+namespace crc32c {
+
+namespace {
+
+constexpr std::uint32_t kPoly = 0x82F63B78u;    // отражённый 0x1EDC6F41
+
+// tables[k][b] — вклад байта b, за которым следуют ещё k байт (slicing-by-8).
+constexpr std::array<std::array<std::uint32_t, 256>, 8> makeTables() {
+    std::array<std::array<std::uint32_t, 256>, 8> t{};
+    for (std::uint32_t b = 0; b < 256; ++b) {
+        std::uint32_t c = b;
+        for (int i = 0; i < 8; ++i) c = (c >> 1) ^ (kPoly & (0u - (c & 1u)));
+        t[0][b] = c;
+    }
+    for (std::size_t k = 1; k < 8; ++k) {
+        for (std::uint32_t b = 0; b < 256; ++b) t[k][b] = (t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xFF];
+    }
+    return t;
+}
+
+constexpr auto kTables = makeTables();
+
+std::uint32_t softwareRaw(std::uint32_t c, const std::uint8_t* p, std::size_t n) noexcept {
+    for (; n >= 8; p += 8, n -= 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p, 8);
+        w ^= c;     // порядок байт — little-endian, как у самих данных
+        c = kTables[7][w & 0xFF] ^ kTables[6][(w >> 8) & 0xFF] ^ kTables[5][(w >> 16) & 0xFF] ^
+            kTables[4][(w >> 24) & 0xFF] ^ kTables[3][(w >> 32) & 0xFF] ^ kTables[2][(w >> 40) & 0xFF] ^
+            kTables[1][(w >> 48) & 0xFF] ^ kTables[0][w >> 56];
+    }
+    for (; n > 0; ++p, --n) c = (c >> 8) ^ kTables[0][(c ^ *p) & 0xFF];
+    return c;
+}
+
+#if defined(CRC32C_X86)
+__attribute__((target("sse4.2")))
+std::uint32_t hardwareRaw(std::uint32_t c, const std::uint8_t* p, std::size_t n) noexcept {
+#if defined(__x86_64__)
+    std::uint64_t c64 = c;
+    for (; n >= 8; p += 8, n -= 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p, 8);
+        c64 = _mm_crc32_u64(c64, w);
+    }
+    c = static_cast<std::uint32_t>(c64);
+#endif
+    for (; n > 0; ++p, --n) c = _mm_crc32_u8(c, *p);
+    return c;
+}
+
+bool detectHardware() noexcept { return __builtin_cpu_supports("sse4.2"); }
+#elif defined(CRC32C_ARM)
+std::uint32_t hardwareRaw(std::uint32_t c, const std::uint8_t* p, std::size_t n) noexcept {
+    for (; n >= 8; p += 8, n -= 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p, 8);
+        c = __crc32cd(c, w);
+    }
+    for (; n > 0; ++p, --n) c = __crc32cb(c, *p);
+    return c;
+}
+
+bool detectHardware() noexcept { return true; }
+#else
+std::uint32_t hardwareRaw(std::uint32_t c, const std::uint8_t* p, std::size_t n) noexcept {
+    return softwareRaw(c, p, n);
+}
+
+bool detectHardware() noexcept { return false; }
+#endif
+
+using RawFn = std::uint32_t (*)(std::uint32_t, const std::uint8_t*, std::size_t) noexcept;
+
+RawFn pick() noexcept { return detectHardware() ? hardwareRaw : softwareRaw; }
+
+} // namespace
+
+std::uint32_t extend(std::uint32_t crc, std::span<const std::uint8_t> data) noexcept {
+    static const RawFn raw = pick();
+    return ~raw(~crc, data.data(), data.size());
+}
+
+std::uint32_t extendSoftware(std::uint32_t crc, std::span<const std::uint8_t> data) noexcept {
+    return ~softwareRaw(~crc, data.data(), data.size());
+}
+
+bool hardwareAvailable() noexcept { return detectHardware(); }
+
+} // namespace crc32c
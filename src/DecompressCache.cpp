@@ -0,0 +1,78 @@
+#include "DecompressCache.hpp"
+
+DecompressCache::Text DecompressCache::find(const std::shared_ptr<FSNode>& node, std::size_t storedSize) {
+    std::lock_guard lk(mu_);
+    auto it = index_.find(node.get());
+    if (it == index_.end()) {
+        ++misses_;
+        return nullptr;
+    }
+    auto e = it->second;
+    // адрес мог достаться новому узлу, а содержимое — поменяться в обход Vfs
+    if (e->owner.lock() != node || e->storedSize != storedSize) {
+        eraseLocked(e);
+        ++misses_;
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, e);
+    ++hits_;
+    return e->text;
+}
+
+void DecompressCache::insert(const std::shared_ptr<FSNode>& node, std::size_t storedSize, Text text) {
+    std::lock_guard lk(mu_);
+    if (auto it = index_.find(node.get()); it != index_.end()) eraseLocked(it->second);
+    if (!text || text->size() > capacity_) return;
+    bytes_ += text->size();
+    lru_.push_front(Entry{node.get(), node, storedSize, std::move(text)});
+    index_[node.get()] = lru_.begin();
+    evictLocked();
+}
+
+void DecompressCache::invalidate(const FSNode* node) {
+    std::lock_guard lk(mu_);
+    if (auto it = index_.find(node); it != index_.end()) eraseLocked(it->second);
+}
+
+void DecompressCache::clear() {
+    std::lock_guard lk(mu_);
+    lru_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+void DecompressCache::setCapacity(std::size_t capacity) {
+    std::lock_guard lk(mu_);
+    capacity_ = capacity;
+    evictLocked();
+}
+
+DecompressCache::Stats DecompressCache::stats() const {
+    std::lock_guard lk(mu_);
+    Stats st;
+    st.hits = hits_;
+    st.misses = misses_;
+    st.evictions = evictions_;
+    st.entries = lru_.size();
+    st.bytes = bytes_;
+    st.capacity = capacity_;
+    return st;
+}
+
+void DecompressCache::resetStats() {
+    std::lock_guard lk(mu_);
+    hits_ = misses_ = evictions_ = 0;
+}
+
+void DecompressCache::eraseLocked(List::iterator it) {
+    bytes_ -= it->text->size();
+    index_.erase(it->key);
+    lru_.erase(it);
+}
+
+void DecompressCache::evictLocked() {
+    while (bytes_ > capacity_ && !lru_.empty()) {
+        eraseLocked(std::prev(lru_.end()));
+        ++evictions_;
+    }
+}
@@ -0,0 +1,100 @@
+#include "DictTrainer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+
+namespace {
+
+constexpr std::size_t kGram = 8;        // k-грамма — единица «встречаемости»
+constexpr std::size_t kSegment = 64;    // длина фрагмента-кандидата
+constexpr std::size_t kStep = 16;       // шаг кандидатов внутри образца
+
+std::uint64_t gramAt(const std::uint8_t* p) noexcept {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+struct Segment {
+    const std::uint8_t* data;
+    std::size_t size;
+};
+
+} // namespace
+
+std::vector<std::uint8_t> trainDictionary(std::span<const std::span<const std::uint8_t>> samples,
+                                          std::size_t maxBytes) {
+    // В скольких образцах встречается каждая k-грамма (повтор внутри образца не в счёт).
+    std::unordered_map<std::uint64_t, std::uint32_t> docs;
+    std::vector<std::uint64_t> grams;
+    for (const auto& s : samples) {
+        if (s.size() < kGram) continue;
+        grams.clear();
+        for (std::size_t i = 0; i + kGram <= s.size(); ++i) grams.push_back(gramAt(s.data() + i));
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+        for (auto g : grams) ++docs[g];
+    }
+
+    // Ценность фрагмента — сумма встречаемости его ещё не покрытых k-грамм;
+    // k-граммы единственного образца словарю бесполезны.
+    auto score = [&](const Segment& seg) {
+        std::uint64_t total = 0;
+        for (std::size_t i = 0; i + kGram <= seg.size; ++i) {
+            auto it = docs.find(gramAt(seg.data + i));
+            if (it != docs.end() && it->second > 1) total += it->second;
+        }
+        return total;
+    };
+
+    std::vector<Segment> segments;
+    for (const auto& s : samples) {
+        if (s.size() < kGram) continue;
+        if (s.size() <= kSegment) {
+            segments.push_back({s.data(), s.size()});
+            continue;
+        }
+        for (std::size_t pos = 0; pos < s.size(); pos += kStep) {
+            const std::size_t from = std::min(pos, s.size() - kSegment);
+            segments.push_back({s.data() + from, kSegment});
+            if (from != pos) break;
+        }
+    }
+
+    // Жадный выбор с ленивым пересчётом: ценность только убывает, поэтому
+    // фрагмент, чья пересчитанная ценность не упала, — лучший из оставшихся.
+    using Item = std::pair<std::uint64_t, std::size_t>;
+    std::priority_queue<Item> queue;
+    for (std::size_t i = 0; i < segments.size(); ++i) {
+        if (auto v = score(segments[i])) queue.push({v, i});
+    }
+    std::vector<std::size_t> chosen;
+    std::size_t bytes = 0;
+    while (!queue.empty() && bytes < maxBytes) {
+        auto [stale, idx] = queue.top();
+        queue.pop();
+        const Segment& seg = segments[idx];
+        const std::uint64_t now = score(seg);
+        if (now == 0) continue;
+        if (now < stale) {
+            queue.push({now, idx});
+            continue;
+        }
+        if (bytes + seg.size > maxBytes) continue;
+        chosen.push_back(idx);
+        bytes += seg.size;
+        for (std::size_t i = 0; i + kGram <= seg.size; ++i) {
+            auto it = docs.find(gramAt(seg.data + i));
+            if (it != docs.end()) it->second = 0;
+        }
+    }
+
+    std::vector<std::uint8_t> dict;
+    dict.reserve(bytes);
+    for (auto it = chosen.rbegin(); it != chosen.rend(); ++it) {
+        dict.insert(dict.end(), segments[*it].data, segments[*it].data + segments[*it].size);
+    }
+    return dict;
+}
@@ -7,11 +7,12 @@
 
 #include <iostream>
 #include <sstream>
+#include <string_view>
 
 namespace FileCommands {
 
-static std::shared_ptr<FSNode> resolveFile(Vfs& vfs, const std::string& path) {
-    auto node = vfs.resolve(path, Vfs::ResolveKind::File);
+static std::shared_ptr<FSNode> resolveFile(Vfs& vfs, const std::string& path, bool forWrite = false) {
+    auto node = forWrite ? vfs.resolveForWrite(path) : vfs.resolve(path, Vfs::ResolveKind::File);
     if (!node) {
         auto alt = vfs.resolve(path, Vfs::ResolveKind::Any);
         if (alt && !alt->isFile) throw VfsException(ErrorCode::FileExpected);
@@ -25,8 +26,8 @@ void cat(Vfs& vfs, const std::vector<std::string>& args) {
         std::cout << "usage: cat <file>\n";
         return;
     }
-    auto file = resolveFile(vfs, args[0]);
-    std::cout << file->content.asText();
+    // сжатый по политике файл показывается распакованным
+    std::cout << vfs.readFile(args[0]);
 }
 
 void echo(Vfs& vfs, const std::vector<std::string>& args) {
@@ -37,7 +38,7 @@ void echo(Vfs& vfs, const std::vector<std::string>& args) {
     std::ostringstream oss;
     for (size_t i = 0; i + 2 < args.size(); ++i)
         oss << args[i] << (i + 3 < args.size() ? " " : "");
-    auto file = resolveFile(vfs, args.back());
+    auto file = resolveFile(vfs, args.back(), true);
     file->content.assignText(oss.str());
     vfs.refreshNodeStats(file);
 }
@@ -50,9 +51,8 @@ void echoAppend(Vfs& vfs, const std::vector<std::string>& args) {
     std::ostringstream oss;
     for (size_t i = 0; i + 2 < args.size(); ++i)
         oss << args[i] << (i + 3 < args.size() ? " " : "");
-    auto file = resolveFile(vfs, args.back());
-    file->content.append(std::vector<uint8_t>(oss.str().begin(), oss.str().end()));
-    vfs.refreshNodeStats(file);
+    // writeFile сам ищет файл и дописывает в сжатый, не распаковывая его целиком
+    vfs.writeFile(args.back(), oss.str(), true);
 }
 
 void nano(Vfs& vfs, const std::vector<std::string>& args) {
@@ -60,7 +60,7 @@ void nano(Vfs& vfs, const std::vector<std::string>& args) {
         std::cout << "usage: nano <file>\n";
         return;
     }
-    auto file = resolveFile(vfs, args[0]);
+    auto file = resolveFile(vfs, args[0], true);
     std::cout << "Enter text. End with a single '.' on a line.\n";
     std::ostringstream oss;
     std::string line;
@@ -77,11 +77,11 @@ void read(Vfs& vfs, const std::vector<std::string>& args) {
         std::cout << "usage: read <file> [offset] [count]\n";
         return;
     }
-    auto file = resolveFile(vfs, args[0]);
+    const std::string text = vfs.readFile(args[0]);
     std::size_t off = args.size() > 1 ? std::stoull(args[1]) : 0;
-    std::size_t cnt = args.size() > 2 ? std::stoull(args[2]) : file->content.size() - off;
-    auto bytes = file->content.read(off, cnt);
-    for (auto b : bytes) {
+    if (off > text.size()) throw VfsException(ErrorCode::OutOfRange);
+    std::size_t cnt = args.size() > 2 ? std::stoull(args[2]) : text.size() - off;
+    for (unsigned char b : std::string_view(text).substr(off, cnt)) {
         std::cout << std::hex << std::uppercase << "0x" << static_cast<int>(b) << " ";
     }
     std::cout << "\n";
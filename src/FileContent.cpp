@@ -1,28 +1,375 @@
 #include "FileContent.hpp"
+#include "BlobStore.hpp"
+#include "HostFile.hpp"
+#include <algorithm>
 #include <cstring>
 
-void FileContent::write(std::size_t off, const std::vector<byte>& buf) {
-    throwIf(off > data_.size(), ErrorCode::OutOfRange);
-    if (off + buf.size() > data_.size()) {
-        data_.resize(off + buf.size());
+namespace {
+
+// Грубая оценка накладных расходов make_shared: управляющий блок + заголовок объекта.
+constexpr std::size_t kSharedOverhead = 2 * sizeof(void*) + sizeof(std::vector<std::uint8_t>);
+
+// Общая страница нулей для чтения дыр.
+constexpr std::array<std::uint8_t, FileContent::kPageSize> kZeroPage{};
+
+template<class Ptr>
+std::size_t ownersOf(const Ptr& p) noexcept {
+    return static_cast<std::size_t>(std::max<long>(p.use_count(), 1));
+}
+
+}
+
+std::size_t FileContent::size() const noexcept {
+    if (auto in = std::get_if<Inline>(&rep_)) return in->len;
+    if (auto buf = std::get_if<BufferPtr>(&rep_)) return (*buf)->size();
+    return table().size;
+}
+
+FileContent::Buffer FileContent::bytes() const {
+    Buffer out;
+    out.reserve(size());
+    forEachChunk([&](const byte* p, std::size_t n) { out.insert(out.end(), p, p + n); });
+    return out;
+}
+
+std::span<const FileContent::byte> FileContent::pageBytes(const PageTable& t, std::size_t idx) noexcept {
+    if (const auto& p = t.pages[idx]) return {p->data(), p->size()};
+    if (fromBase(t, idx)) return {t.base->data() + idx * kPageSize, pageLen(t, idx)};
+    return {kZeroPage.data(), pageLen(t, idx)};
+}
+
+const void* FileContent::pageId(const PageTable& t, std::size_t idx) noexcept {
+    if (const auto& p = t.pages[idx]) return p.get();
+    if (fromBase(t, idx)) return t.base->data() + idx * kPageSize;
+    return nullptr;
+}
+
+bool FileContent::sharesStorageWith(const FileContent& other) const noexcept {
+    if (auto buf = std::get_if<BufferPtr>(&rep_)) {
+        auto o = std::get_if<BufferPtr>(&other.rep_);
+        return o && *o == *buf;
+    }
+    if (auto t = std::get_if<TablePtr>(&rep_)) {
+        auto o = std::get_if<TablePtr>(&other.rep_);
+        if (!o) return false;
+        if (*o == *t) return true;
+        std::size_t n = std::min((*t)->pages.size(), (*o)->pages.size());
+        for (std::size_t i = 0; i < n; ++i) {
+            const void* id = pageId(**t, i);
+            if (id && id == pageId(**o, i)) return true;
+        }
+    }
+    return false;
+}
+
+std::size_t FileContent::physicalBytes() const noexcept {
+    if (auto in = std::get_if<Inline>(&rep_)) return in->len;
+    if (auto buf = std::get_if<BufferPtr>(&rep_)) return (*buf)->size() / ownersOf(*buf);
+    const auto& t = std::get<TablePtr>(rep_);
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < t->pages.size(); ++i) {
+        const auto& p = t->pages[i];
+        if (p) total += p->size() / ownersOf(p);
+        else if (fromBase(*t, i)) total += pageLen(*t, i);
+    }
+    return total / ownersOf(t);
+}
+
+std::size_t FileContent::allocatedBytes() const noexcept {
+    if (!paged()) return size();
+    const auto& t = table();
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < t.pages.size(); ++i) {
+        if (pageId(t, i)) total += pageLen(t, i);
+    }
+    return total;
+}
+
+std::size_t FileContent::heapBytes() const noexcept {
+    if (isInline()) return 0;
+    if (auto buf = std::get_if<BufferPtr>(&rep_))
+        return ((*buf)->capacity() + kSharedOverhead) / ownersOf(*buf);
+    const auto& t = std::get<TablePtr>(rep_);
+    std::size_t total = sizeof(PageTable) + kSharedOverhead + t->pages.capacity() * sizeof(BufferPtr);
+    for (const auto& p : t->pages) {
+        if (p) total += (p->capacity() + kSharedOverhead) / ownersOf(p);
+    }
+    return total / ownersOf(t);
+}
+
+std::size_t FileContent::mappedBytes() const noexcept {
+    if (!hostBacked()) return 0;
+    const auto& t = table();
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < t.pages.size(); ++i) {
+        if (fromBase(t, i)) total += pageLen(t, i);
+    }
+    return total;
+}
+
+void FileContent::mapHostFile(std::shared_ptr<const HostFile> file) {
+    if (file->size() <= kInlineCapacity) {
+        replaceAll(std::span<const byte>(file->data(), file->size()));
+        return;
+    }
+    auto table = std::make_shared<PageTable>();
+    table->size = file->size();
+    table->pages.resize((file->size() - 1) / kPageSize + 1);
+    table->baseSize = file->size();
+    table->base = std::move(file);
+    rep_ = std::move(table);
+}
+
+void FileContent::intern(BlobStore& store) {
+    // Замена указателя на буфер с тем же содержимым безопасна и для разделяемой таблицы.
+    if (auto buf = std::get_if<BufferPtr>(&rep_)) { *buf = store.intern(*buf); return; }
+    if (auto t = std::get_if<TablePtr>(&rep_)) {
+        for (auto& p : (*t)->pages) {
+            if (p) p = store.intern(p);
+        }
+    }
+}
+
+FileContent::PageTable& FileContent::mutableTable() {
+    auto& t = std::get<TablePtr>(rep_);
+    if (t.use_count() > 1) t = std::make_shared<PageTable>(*t);
+    return *t;
+}
+
+FileContent::Buffer& FileContent::mutablePage(PageTable& t, std::size_t idx) {
+    auto& p = t.pages[idx];
+    if (!p) {
+        // первая запись в страницу из отображения или в дыру — выделяем только её
+        auto s = pageBytes(t, idx);
+        p = std::make_shared<Buffer>();
+        p->reserve(kPageSize);
+        p->assign(s.begin(), s.end());
+    } else if (p.use_count() > 1) {
+        p = std::make_shared<Buffer>(*p);
+    }
+    return *p;
+}
+
+void FileContent::toPaged() {
+    if (paged()) return;
+    auto table = std::make_shared<PageTable>();
+    if (auto in = std::get_if<Inline>(&rep_)) {
+        // пустой файл — пустая таблица, чтобы запись далеко за концом не выделяла первую страницу
+        if (in->len) {
+            auto page = std::make_shared<Buffer>(in->data.begin(), in->data.begin() + in->len);
+            page->reserve(kPageSize);
+            table->pages.push_back(std::move(page));
+        }
+        table->size = in->len;
+    } else {
+        // Обычно буфер не больше страницы и просто становится первой страницей;
+        // крупный буфер, принятый через replaceAll(&&), режется на страницы один раз.
+        auto buf = std::move(std::get<BufferPtr>(rep_));
+        table->size = buf->size();
+        if (buf->size() <= kPageSize) {
+            if (!buf->empty()) table->pages.push_back(std::move(buf));
+        } else {
+            for (std::size_t off = 0; off < buf->size(); off += kPageSize) {
+                std::size_t len = std::min(kPageSize, buf->size() - off);
+                auto page = std::make_shared<Buffer>();
+                page->reserve(kPageSize);
+                page->assign(buf->begin() + static_cast<long>(off), buf->begin() + static_cast<long>(off + len));
+                table->pages.push_back(std::move(page));
+            }
+        }
+    }
+    rep_ = std::move(table);
+}
+
+void FileContent::extendPaged(std::size_t newSize) {
+    auto& t = mutableTable();
+    if (newSize <= t.size) return;
+    // Хвост с данными дописываем нулями до новой длины (или до конца страницы);
+    // всё дальше — дыры, которые памяти не требуют.
+    if (!t.pages.empty()) {
+        std::size_t tail = t.pages.size() - 1;
+        if (pageLen(t, tail) < kPageSize && pageId(t, tail)) {
+            std::size_t len = std::min(kPageSize, newSize - tail * kPageSize);
+            mutablePage(t, tail).resize(len);
+        }
+    }
+    t.pages.resize((newSize - 1) / kPageSize + 1);
+    t.size = newSize;
+}
+
+void FileContent::shrinkRepresentation() {
+    // После усечения возвращаемся к более компактному представлению.
+    std::size_t n = size();
+    if (n <= kInlineCapacity && !isInline()) {
+        Inline in;
+        in.len = static_cast<std::uint8_t>(n);
+        copyOut(0, in.data.data(), n);
+        rep_ = in;
+        return;
+    }
+    if (auto t = std::get_if<TablePtr>(&rep_); t && (*t)->pages.size() == 1 && (*t)->pages.front()) {
+        BufferPtr page = (*t)->pages.front();
+        rep_ = std::move(page);
+    }
+}
+
+void FileContent::writeBytes(std::size_t off, const byte* src, std::size_t n) {
+    if (n == 0) return;
+    std::size_t end = off + n;
+
+    if (auto in = std::get_if<Inline>(&rep_)) {
+        if (end <= kInlineCapacity) {
+            if (off > in->len) std::memset(in->data.data() + in->len, 0, off - in->len);
+            std::memcpy(in->data.data() + off, src, n);
+            in->len = static_cast<std::uint8_t>(std::max<std::size_t>(in->len, end));
+            return;
+        }
+        // Вытесняем встроенное содержимое в кучу.
+        auto buf = std::make_shared<Buffer>(in->data.begin(), in->data.begin() + in->len);
+        rep_ = std::move(buf);
+    }
+
+    if (auto buf = std::get_if<BufferPtr>(&rep_)) {
+        auto& b = *buf;
+        bool ownsLarge = b.use_count() == 1 && end <= b->size();
+        if (end <= kPageSize || ownsLarge) {
+            if (b.use_count() > 1) b = std::make_shared<Buffer>(*b);
+            if (end > b->size()) b->resize(end);
+            std::memcpy(b->data() + off, src, n);
+            return;
+        }
+    }
+
+    toPaged();
+    extendPaged(end);
+    auto& t = mutableTable();
+    // После extendPaged каждая выделенная страница имеет длину pageLen,
+    // так что остаётся только скопировать байты в затронутые страницы.
+    while (n > 0) {
+        std::size_t idx = off / kPageSize;
+        std::size_t inPage = off % kPageSize;
+        std::size_t chunk = std::min(n, kPageSize - inPage);
+        auto& page = mutablePage(t, idx);
+        std::memcpy(page.data() + inPage, src, chunk);
+        off += chunk;
+        src += chunk;
+        n -= chunk;
     }
-    std::memcpy(data_.data() + off, buf.data(), buf.size());
 }
 
-void FileContent::append(const std::vector<byte>& buf) {
-    data_.insert(data_.end(), buf.begin(), buf.end());
+void FileContent::copyOut(std::size_t off, byte* dst, std::size_t n) const {
+    while (n > 0) {
+        auto v = view(off, n);
+        std::memcpy(dst, v.data(), v.size());
+        off += v.size();
+        dst += v.size();
+        n -= v.size();
+    }
+}
+
+std::span<const FileContent::byte> FileContent::view(std::size_t off, std::size_t n) const {
+    throwIf(off > size(), ErrorCode::OutOfRange);
+    std::size_t len = std::min(n, size() - off);
+    if (len == 0) return {};
+    if (auto in = std::get_if<Inline>(&rep_)) return {in->data.data() + off, len};
+    if (auto buf = std::get_if<BufferPtr>(&rep_)) return {(*buf)->data() + off, len};
+    auto page = pageBytes(table(), off / kPageSize);
+    std::size_t inPage = off % kPageSize;
+    return {page.data() + inPage, std::min(len, page.size() - inPage)};
+}
+
+std::size_t FileContent::readInto(std::size_t off, std::span<byte> dst) const {
+    throwIf(off > size(), ErrorCode::OutOfRange);
+    std::size_t len = std::min(dst.size(), size() - off);
+    copyOut(off, dst.data(), len);
+    return len;
+}
+
+void FileContent::write(std::size_t off, std::span<const byte> buf) {
+    writeBytes(off, buf.data(), buf.size());
+}
+
+void FileContent::append(std::span<const byte> buf) {
+    writeBytes(size(), buf.data(), buf.size());
 }
 
 std::vector<FileContent::byte> FileContent::read(std::size_t off, std::size_t n) const {
-    throwIf(off > data_.size(), ErrorCode::OutOfRange);
-    std::size_t len = std::min(n, data_.size() - off);
-    return {data_.begin() + off, data_.begin() + off + len};
+    throwIf(off > size(), ErrorCode::OutOfRange);
+    std::vector<byte> out(std::min(n, size() - off));
+    copyOut(off, out.data(), out.size());
+    return out;
+}
+
+std::string FileContent::asText() const {
+    std::string out;
+    out.reserve(size());
+    forEachChunk([&](const byte* p, std::size_t n) {
+        out.append(reinterpret_cast<const char*>(p), n);
+    });
+    return out;
 }
 
 void FileContent::truncate(std::size_t newSize) {
-    data_.resize(newSize);
+    std::size_t cur = size();
+    if (newSize == cur) return;
+    if (newSize == 0) {
+        rep_ = Inline{};
+        return;
+    }
+    if (newSize > cur) {
+        // Небольшое расширение дописывает нули; большое оставляет дыру.
+        if (!paged() && newSize <= kPageSize) {
+            std::vector<byte> zeros(newSize - cur, 0);
+            writeBytes(cur, zeros.data(), zeros.size());
+        } else {
+            toPaged();
+            extendPaged(newSize);
+        }
+        return;
+    }
+    if (auto in = std::get_if<Inline>(&rep_)) {
+        in->len = static_cast<std::uint8_t>(newSize);
+        return;
+    }
+    if (auto buf = std::get_if<BufferPtr>(&rep_)) {
+        auto& b = *buf;
+        if (newSize > kInlineCapacity) {
+            if (b.use_count() > 1) b = std::make_shared<Buffer>(b->begin(), b->begin() + static_cast<long>(newSize));
+            else b->resize(newSize);
+            return;
+        }
+        Inline in;
+        in.len = static_cast<std::uint8_t>(newSize);
+        std::memcpy(in.data.data(), b->data(), newSize);
+        rep_ = in;
+        return;
+    }
+    auto& t = mutableTable();
+    std::size_t keep = (newSize - 1) / kPageSize + 1;
+    t.pages.resize(keep);
+    std::size_t tail = newSize - (keep - 1) * kPageSize;
+    if (t.pages.back() && t.pages.back()->size() != tail) mutablePage(t, keep - 1).resize(tail);
+    // Отображение за новым концом больше не видно: при расширении там будут нули.
+    t.baseSize = std::min(t.baseSize, newSize);
+    t.size = newSize;
+    shrinkRepresentation();
 }
 
-void FileContent::replaceAll(const std::vector<byte>& buf) {
-    data_ = buf;
+void FileContent::replaceAll(std::span<const byte> buf) {
+    // Новые буферы: старые (возможно, разделяемые) не трогаем.
+    rep_ = Inline{};
+    if (buf.size() <= kPageSize) {
+        if (buf.size() <= kInlineCapacity) writeBytes(0, buf.data(), buf.size());
+        else rep_ = std::make_shared<Buffer>(buf.begin(), buf.end());
+        return;
+    }
+    writeBytes(0, buf.data(), buf.size());
+}
+
+void FileContent::replaceAll(std::vector<byte>&& buf) {
+    if (buf.size() <= kInlineCapacity) {
+        replaceAll(std::span<const byte>(buf));
+        return;
+    }
+    rep_ = std::make_shared<Buffer>(std::move(buf));
 }
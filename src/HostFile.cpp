@@ -0,0 +1,48 @@
+#include "HostFile.hpp"
+#include "Errors.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+std::shared_ptr<const HostFile> HostFile::open(const std::string& path) {
+    std::shared_ptr<HostFile> f(new HostFile());
+    f->path_ = path;
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw VfsException(ErrorCode::NotFound);
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) { ::close(fd); throw VfsException(ErrorCode::IOError); }
+    if (!S_ISREG(st.st_mode)) { ::close(fd); throw VfsException(ErrorCode::FileExpected); }
+    f->size_ = static_cast<std::size_t>(st.st_size);
+    if (f->size_ > 0) {
+        void* p = ::mmap(nullptr, f->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) { ::close(fd); throw VfsException(ErrorCode::IOError); }
+        // Чтение в основном последовательное — просим ядро читать вперёд.
+        ::madvise(p, f->size_, MADV_SEQUENTIAL);
+        f->data_ = static_cast<const std::uint8_t*>(p);
+        f->mapped_ = true;
+    }
+    // Отображение остаётся действительным и после закрытия дескриптора.
+    ::close(fd);
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw VfsException(ErrorCode::NotFound);
+    f->fallback_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    f->data_ = f->fallback_.data();
+    f->size_ = f->fallback_.size();
+#endif
+    return f;
+}
+
+HostFile::~HostFile() {
+#ifndef _WIN32
+    if (mapped_) ::munmap(const_cast<std::uint8_t*>(data_), size_);
+#endif
+}
@@ -0,0 +1,200 @@
+#include "LzFast.hpp"
+#include "Errors.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace lzfast {
+
+namespace {
+
+// Запас в конце буфера вывода: совпадения копируются словами по 8 байт.
+constexpr std::size_t kCopySlack = 8;
+
+std::uint32_t load32(const std::uint8_t* p) noexcept {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+std::size_t matchLength(const std::uint8_t* a, const std::uint8_t* b, const std::uint8_t* end) noexcept {
+    const std::uint8_t* start = b;
+    while (b + 8 <= end) {
+        std::uint64_t x, y;
+        std::memcpy(&x, a, 8);
+        std::memcpy(&y, b, 8);
+        if (std::uint64_t diff = x ^ y) return static_cast<std::size_t>(b - start) + (std::countr_zero(diff) >> 3);
+        a += 8;
+        b += 8;
+    }
+    while (b < end && *a == *b) { ++a; ++b; }
+    return static_cast<std::size_t>(b - start);
+}
+
+void putLength(std::vector<std::uint8_t>& out, std::size_t len) {
+    for (; len >= 255; len -= 255) out.push_back(255);
+    out.push_back(static_cast<std::uint8_t>(len));
+}
+
+void putSequence(std::vector<std::uint8_t>& out, const std::uint8_t* lit, std::size_t litLen,
+                 std::size_t offset, std::size_t matchLen) {
+    const std::size_t ml = matchLen ? matchLen - kMinMatch : 0;
+    out.push_back(static_cast<std::uint8_t>((std::min<std::size_t>(litLen, 15) << 4) | std::min<std::size_t>(ml, 15)));
+    if (litLen >= 15) putLength(out, litLen - 15);
+    out.insert(out.end(), lit, lit + litLen);
+    if (!matchLen) return;
+    out.push_back(static_cast<std::uint8_t>(offset));
+    out.push_back(static_cast<std::uint8_t>(offset >> 8));
+    if (ml >= 15) putLength(out, ml - 15);
+}
+
+std::size_t getLength(const std::uint8_t*& ip, const std::uint8_t* end, std::size_t limit) {
+    std::size_t len = 0;
+    std::uint8_t b;
+    do {
+        if (ip == end) throw VfsException(ErrorCode::Corrupted);
+        b = *ip++;
+        len += b;
+        if (len > limit) throw VfsException(ErrorCode::Corrupted);
+    } while (b == 255);
+    return len;
+}
+
+} // namespace
+
+std::uint32_t MatchFinder::hashAt(const std::uint8_t* p) const noexcept {
+    return (load32(p) * 2654435761u) >> (32 - kHashBits);
+}
+
+void MatchFinder::insert(const std::uint8_t* src, std::size_t pos) noexcept {
+    std::uint32_t h = hashAt(src + pos);
+    chain_[pos] = head_[h];
+    head_[h] = static_cast<std::uint32_t>(pos);
+}
+
+std::size_t MatchFinder::longest(const std::uint8_t* src, std::size_t n, std::size_t pos, std::size_t& offset) noexcept {
+    std::uint32_t cand = head_[hashAt(src + pos)];
+    insert(src, pos);
+    std::size_t bestLen = 0;
+    const std::uint32_t cur = load32(src + pos);
+    for (int depth = maxChain_; cand != kNone && pos - cand <= kMaxOffset && depth > 0; --depth) {
+        if (load32(src + cand) == cur) {
+            std::size_t len = kMinMatch + matchLength(src + cand + kMinMatch, src + pos + kMinMatch, src + n);
+            if (len > bestLen) {
+                bestLen = len;
+                offset = pos - cand;
+                if (pos + len == n || len >= kGoodMatch) break;
+            }
+        }
+        cand = chain_[cand];
+    }
+    return bestLen;
+}
+
+void MatchFinder::parse(std::span<const std::uint8_t> in, std::vector<Sequence>& out, std::size_t start) {
+    const std::uint8_t* src = in.data();
+    const std::size_t n = in.size();
+    head_.assign(std::size_t{1} << kHashBits, kNone);
+    chain_.resize(n);
+    for (std::size_t pos = 0; pos < start && pos + kMinMatch <= n; ++pos) insert(src, pos);
+
+    std::size_t anchor = start;
+    std::size_t i = start;
+    while (i + kMinMatch <= n) {
+        std::size_t offset = 0;
+        std::size_t len = longest(src, n, i, offset);
+        if (len < kMinMatch) {
+            // Чем дольше нет совпадений, тем крупнее шаг: несжимаемые данные
+            // проходятся быстро, а не перебором каждой позиции.
+            i += 1 + ((i - anchor) >> 6);
+            continue;
+        }
+        // ленивый разбор: совпадение с позиции правее может оказаться длиннее
+        while (lazy_ && len < kGoodMatch && i + 1 + kMinMatch <= n) {
+            std::size_t nextOffset = 0;
+            std::size_t next = longest(src, n, i + 1, nextOffset);
+            if (next <= len) break;
+            ++i;
+            len = next;
+            offset = nextOffset;
+        }
+        out.push_back(Sequence{static_cast<std::uint32_t>(i - anchor), static_cast<std::uint32_t>(offset),
+                               static_cast<std::uint32_t>(len)});
+        const std::size_t end = i + len;
+        // внутрь совпадения заглядываем только у его конца: почти та же степень
+        // сжатия, а хешировать каждый байт совпадения заметно дороже
+        if (end - 2 > i && end - 2 + kMinMatch <= n) insert(src, end - 2);
+        i = anchor = end;
+    }
+    out.push_back(Sequence{static_cast<std::uint32_t>(n - anchor), 0, 0});
+}
+
+void Compressor::compress(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out,
+                          std::span<const std::uint8_t> dict) {
+    seqs_.clear();
+    const std::uint8_t* lit = in.data();
+    if (dict.empty()) {
+        finder_.parse(in, seqs_);
+    } else {
+        window_.assign(dict.begin(), dict.end());
+        window_.insert(window_.end(), in.begin(), in.end());
+        finder_.parse(window_, seqs_, dict.size());
+        lit = window_.data() + dict.size();
+    }
+    out.reserve(out.size() + in.size() + in.size() / 255 + 16);
+    for (const auto& s : seqs_) {
+        putSequence(out, lit, s.litLen, s.offset, s.matchLen);
+        lit += s.litLen + s.matchLen;
+    }
+}
+
+void decompress(std::span<const std::uint8_t> in, std::size_t expected, std::vector<std::uint8_t>& out,
+                std::span<const std::uint8_t> dict) {
+    // словарь кладётся перед выводом как уже выданная история
+    const std::size_t base = out.size();
+    out.resize(base + dict.size() + expected + kCopySlack);
+    std::uint8_t* const start = out.data() + base;
+    if (!dict.empty()) std::memcpy(start, dict.data(), dict.size());
+    std::uint8_t* op = start + dict.size();
+    std::uint8_t* const oend = op + expected;
+    const std::uint8_t* ip = in.data();
+    const std::uint8_t* const iend = ip + in.size();
+
+    while (true) {
+        if (ip == iend) throw VfsException(ErrorCode::Corrupted);
+        const std::uint8_t token = *ip++;
+        std::size_t lit = token >> 4;
+        if (lit == 15) lit += getLength(ip, iend, expected);
+        if (lit > static_cast<std::size_t>(iend - ip) || lit > static_cast<std::size_t>(oend - op))
+            throw VfsException(ErrorCode::Corrupted);
+        std::memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+        if (ip == iend) break;
+
+        if (iend - ip < 2) throw VfsException(ErrorCode::Corrupted);
+        const std::size_t offset = ip[0] | (static_cast<std::size_t>(ip[1]) << 8);
+        ip += 2;
+        std::size_t len = token & 15;
+        if (len == 15) len += getLength(ip, iend, expected);
+        len += kMinMatch;
+        if (offset == 0 || offset > static_cast<std::size_t>(op - start) || len > static_cast<std::size_t>(oend - op))
+            throw VfsException(ErrorCode::Corrupted);
+
+        const std::uint8_t* match = op - offset;
+        if (offset >= 8) {
+            // словами по 8 байт; хвост может залезть в запас за oend
+            for (std::size_t k = 0; k < len; k += 8) std::memcpy(op + k, match + k, 8);
+        } else {
+            // перекрывающееся совпадение повторяет короткий шаблон
+            for (std::size_t k = 0; k < len; ++k) op[k] = match[k];
+        }
+        op += len;
+    }
+    if (op != oend) throw VfsException(ErrorCode::Corrupted);
+    if (!dict.empty()) std::memmove(start, start + dict.size(), expected);
+    out.resize(base + expected);
+}
+
+} // namespace lzfast
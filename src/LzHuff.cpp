@@ -0,0 +1,329 @@
+#include "LzHuff.hpp"
+#include "Errors.hpp"
+#include "Lzw.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <queue>
+
+namespace lzhuff {
+
+namespace {
+
+using lzfast::kMinMatch;
+
+// Алфавит «литерал/длина»: байты, конец блока, коды длин совпадения.
+constexpr std::uint32_t kEndOfBlock = 256;
+constexpr std::uint32_t kFirstLenCode = 257;
+constexpr int kLenDirectLog = 4;       // длины 4..19 — свои коды
+constexpr std::size_t kLenCodes = 48;  // хватает на длины до 2^19
+constexpr std::size_t kLitLenSymbols = kFirstLenCode + kLenCodes;
+constexpr int kDistDirectLog = 2;      // смещения 1..4 — свои коды
+constexpr std::size_t kDistSymbols = 32;  // хватает на смещения до 2^16
+constexpr std::size_t kHeaderBytes = (kLitLenSymbols + kDistSymbols + 1) / 2;
+// Доп. битов у последнего кода алфавита из codes кодов (см. bucketOf ниже).
+constexpr int maxExtraBits(std::size_t codes, int directLog) {
+    return static_cast<int>((codes - (std::size_t{1} << directLog) - 1) / 2) + directLog - 1;
+}
+// Больше битов на одну последовательность не бывает: код длины с доп. битами (18)
+// и код смещения с доп. битами (14) — 12 + 18 + 12 + 14 = 56.
+constexpr int kMaxSeqBits = 2 * kMaxCodeLen + maxExtraBits(kLenCodes, kLenDirectLog) +
+                            maxExtraBits(kDistSymbols, kDistDirectLog);
+constexpr std::size_t kCopySlack = 8;
+
+// Значения ниже 2^directLog — собственный код; дальше по два кода на степень
+// двойки (старший бит после ведущего), остальные биты пишутся как есть.
+struct Bucket {
+    std::uint32_t code;
+    int extraBits;
+    std::uint32_t extra;
+};
+
+Bucket bucketOf(std::uint32_t v, int directLog) noexcept {
+    if (v < (1u << directLog)) return {v, 0, 0};
+    const int k = std::bit_width(v) - 1;
+    const std::uint32_t half = (v >> (k - 1)) & 1u;
+    return {(1u << directLog) + static_cast<std::uint32_t>(k - directLog) * 2 + half, k - 1,
+            v & ((1u << (k - 1)) - 1)};
+}
+
+void bucketBase(std::uint32_t code, int directLog, std::uint32_t& base, int& extraBits) noexcept {
+    if (code < (1u << directLog)) { base = code; extraBits = 0; return; }
+    const std::uint32_t c = code - (1u << directLog);
+    const int k = static_cast<int>(c / 2) + directLog;
+    base = (2u | (c & 1u)) << (k - 1);
+    extraBits = k - 1;
+}
+
+// ======= Хаффман =======
+
+// Длины кодов Хаффмана для частот freq, не длиннее kMaxCodeLen.
+void buildLengths(std::span<const std::uint32_t> freq, std::span<std::uint8_t> lens) {
+    std::fill(lens.begin(), lens.end(), 0);
+    std::vector<std::uint32_t> used;
+    for (std::uint32_t s = 0; s < freq.size(); ++s) if (freq[s]) used.push_back(s);
+    if (used.empty()) return;
+    if (used.size() == 1) { lens[used[0]] = 1; return; }
+
+    // Обычное дерево Хаффмана: листья 0..m-1, внутренние узлы дальше.
+    const std::size_t m = used.size();
+    std::vector<std::uint64_t> weight(2 * m);
+    std::vector<std::uint32_t> parent(2 * m, 0);
+    using Item = std::pair<std::uint64_t, std::uint32_t>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> heap;
+    for (std::size_t i = 0; i < m; ++i) {
+        weight[i] = freq[used[i]];
+        heap.push({weight[i], static_cast<std::uint32_t>(i)});
+    }
+    std::uint32_t next = static_cast<std::uint32_t>(m);
+    while (heap.size() > 1) {
+        auto [wa, a] = heap.top(); heap.pop();
+        auto [wb, b] = heap.top(); heap.pop();
+        weight[next] = wa + wb;
+        parent[a] = parent[b] = next;
+        heap.push({weight[next], next});
+        ++next;
+    }
+    const std::uint32_t root = next - 1;
+    std::vector<int> depth(2 * m, 0);
+    for (std::uint32_t i = root; i-- > 0; ) depth[i] = depth[parent[i]] + 1;
+
+    // Ограничение длины: обрезаем до предела, затем удлиняем самые длинные из
+    // оставшихся (при равной длине — более редкие), пока не выполнится неравенство Крафта.
+    std::uint64_t kraft = 0;
+    for (std::size_t i = 0; i < m; ++i) {
+        int len = std::min(depth[i], kMaxCodeLen);
+        lens[used[i]] = static_cast<std::uint8_t>(len);
+        kraft += std::uint64_t{1} << (kMaxCodeLen - len);
+    }
+    const std::uint64_t full = std::uint64_t{1} << kMaxCodeLen;
+    if (kraft <= full) return;
+    std::sort(used.begin(), used.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return lens[a] != lens[b] ? lens[a] > lens[b] : freq[a] < freq[b];
+    });
+    while (kraft > full) {
+        for (std::uint32_t s : used) {
+            if (lens[s] >= kMaxCodeLen) continue;
+            ++lens[s];
+            kraft -= std::uint64_t{1} << (kMaxCodeLen - lens[s]);
+            if (kraft <= full) break;
+        }
+    }
+}
+
+// Канонические коды, развёрнутые под запись от младшего бита.
+void buildCodes(std::span<const std::uint8_t> lens, std::span<std::uint32_t> codes) {
+    std::array<std::uint32_t, kMaxCodeLen + 2> count{}, next{};
+    for (auto l : lens) ++count[l];
+    count[0] = 0;
+    for (int len = 1; len <= kMaxCodeLen; ++len) next[len + 1] = (next[len] + count[len]) << 1;
+    for (std::size_t s = 0; s < lens.size(); ++s) {
+        const int len = lens[s];
+        if (!len) continue;
+        std::uint32_t code = next[len]++;
+        std::uint32_t rev = 0;
+        for (int b = 0; b < len; ++b) rev |= ((code >> b) & 1u) << (len - 1 - b);
+        codes[s] = rev;
+    }
+}
+
+// Таблица декодера: по kMaxCodeLen следующим битам — символ << 4 | длина кода.
+// Длина 0 — такого кода нет (повреждённые данные).
+void buildTable(std::span<const std::uint8_t> lens, std::vector<std::uint16_t>& table) {
+    std::uint64_t kraft = 0;
+    for (auto l : lens) {
+        if (l > kMaxCodeLen) throw VfsException(ErrorCode::Corrupted);
+        if (l) kraft += std::uint64_t{1} << (kMaxCodeLen - l);
+    }
+    if (kraft > (std::uint64_t{1} << kMaxCodeLen)) throw VfsException(ErrorCode::Corrupted);
+    std::vector<std::uint32_t> codes(lens.size());
+    buildCodes(lens, codes);
+    table.assign(std::size_t{1} << kMaxCodeLen, 0);
+    for (std::size_t s = 0; s < lens.size(); ++s) {
+        if (!lens[s]) continue;
+        const auto entry = static_cast<std::uint16_t>((s << 4) | lens[s]);
+        for (std::uint32_t j = codes[s]; j < table.size(); j += 1u << lens[s]) table[j] = entry;
+    }
+}
+
+// Чтение битов от младшего; за концом входа — нули, перерасход проверяется в конце.
+class BitIn {
+public:
+    // После refill в аккумуляторе не меньше стольких бит.
+    static constexpr int kRefillBits = 56;
+
+    BitIn(const std::uint8_t* p, const std::uint8_t* end) noexcept : begin_(p), p_(p), end_(end) {}
+
+    int available() const noexcept { return count_; }
+    void refill() noexcept {
+        if (end_ - p_ >= 8) {
+            std::uint64_t w;
+            std::memcpy(&w, p_, 8);
+            if constexpr (std::endian::native == std::endian::big) w = std::byteswap(w);
+            acc_ |= w << count_;
+            p_ += (63 - count_) >> 3;
+            count_ |= kRefillBits;
+            return;
+        }
+        while (count_ < kRefillBits) {
+            if (p_ < end_) acc_ |= static_cast<std::uint64_t>(*p_++) << count_;
+            else padding_ += 8;
+            count_ += 8;
+        }
+    }
+    std::uint32_t peek(int n) const noexcept { return static_cast<std::uint32_t>(acc_) & ((1u << n) - 1u); }
+    void consume(int n) noexcept { acc_ >>= n; count_ -= n; }
+    // Поток закончился ровно в пределах последнего байта.
+    bool exhausted() const noexcept {
+        const std::uint64_t total = static_cast<std::uint64_t>(end_ - begin_) * 8;
+        const std::uint64_t consumed = static_cast<std::uint64_t>(p_ - begin_) * 8 + padding_ - count_;
+        return consumed <= total && total - consumed < 8;
+    }
+
+private:
+    const std::uint8_t* begin_;
+    const std::uint8_t* p_;
+    const std::uint8_t* end_;
+    std::uint64_t acc_{0};
+    int count_{0};
+    std::uint64_t padding_{0};
+};
+
+// Декодер доливает биты раз на последовательность и читает её целиком без проверок.
+static_assert(kMaxSeqBits <= BitIn::kRefillBits, "sequence must fit into one refill");
+
+std::uint32_t decodeSymbol(BitIn& in, const std::vector<std::uint16_t>& table) {
+    const std::uint16_t e = table[in.peek(kMaxCodeLen)];
+    const int len = e & 15;
+    if (!len) throw VfsException(ErrorCode::Corrupted);
+    in.consume(len);
+    return e >> 4;
+}
+
+} // namespace
+
+void Compressor::compress(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out) {
+    seqs_.clear();
+    finder_.parse(in, seqs_);
+
+    std::array<std::uint32_t, kLitLenSymbols> litFreq{};
+    std::array<std::uint32_t, kDistSymbols> distFreq{};
+    const std::uint8_t* p = in.data();
+    for (const auto& s : seqs_) {
+        for (std::uint32_t i = 0; i < s.litLen; ++i) ++litFreq[p[i]];
+        p += s.litLen + s.matchLen;
+        if (!s.matchLen) continue;
+        ++litFreq[kFirstLenCode + bucketOf(s.matchLen - kMinMatch, kLenDirectLog).code];
+        ++distFreq[bucketOf(s.offset - 1, kDistDirectLog).code];
+    }
+    ++litFreq[kEndOfBlock];
+
+    std::array<std::uint8_t, kLitLenSymbols> litLens{};
+    std::array<std::uint8_t, kDistSymbols> distLens{};
+    buildLengths(litFreq, litLens);
+    buildLengths(distFreq, distLens);
+    std::array<std::uint32_t, kLitLenSymbols> litCodes{};
+    std::array<std::uint32_t, kDistSymbols> distCodes{};
+    buildCodes(litLens, litCodes);
+    buildCodes(distLens, distCodes);
+
+    // Точный размер потока известен по частотам — выделяем сразу.
+    std::uint64_t bits = 0;
+    for (std::size_t s = 0; s < kLitLenSymbols; ++s) {
+        std::uint32_t base = 0;
+        int extra = 0;
+        if (s >= kFirstLenCode) bucketBase(static_cast<std::uint32_t>(s - kFirstLenCode), kLenDirectLog, base, extra);
+        bits += std::uint64_t{litFreq[s]} * (litLens[s] + extra);
+    }
+    for (std::size_t s = 0; s < kDistSymbols; ++s) {
+        std::uint32_t base = 0;
+        int extra = 0;
+        bucketBase(static_cast<std::uint32_t>(s), kDistDirectLog, base, extra);
+        bits += std::uint64_t{distFreq[s]} * (distLens[s] + extra);
+    }
+
+    const std::size_t start = out.size();
+    out.resize(start + kHeaderBytes + static_cast<std::size_t>(bits / 8) + 16);
+    std::uint8_t* hdr = out.data() + start;
+    std::memset(hdr, 0, kHeaderBytes);
+    for (std::size_t i = 0; i < kLitLenSymbols + kDistSymbols; ++i) {
+        const std::uint8_t len = i < kLitLenSymbols ? litLens[i] : distLens[i - kLitLenSymbols];
+        hdr[i / 2] |= static_cast<std::uint8_t>(len << (4 * (i & 1)));
+    }
+
+    lzw::BitWriter w;
+    w.begin(hdr + kHeaderBytes);
+    p = in.data();
+    for (const auto& s : seqs_) {
+        for (std::uint32_t i = 0; i < s.litLen; ++i) w.put(litCodes[p[i]], litLens[p[i]]);
+        p += s.litLen + s.matchLen;
+        if (!s.matchLen) continue;
+        const Bucket len = bucketOf(s.matchLen - kMinMatch, kLenDirectLog);
+        w.put(litCodes[kFirstLenCode + len.code], litLens[kFirstLenCode + len.code]);
+        if (len.extraBits) w.put(len.extra, len.extraBits);
+        const Bucket dist = bucketOf(s.offset - 1, kDistDirectLog);
+        w.put(distCodes[dist.code], distLens[dist.code]);
+        if (dist.extraBits) w.put(dist.extra, dist.extraBits);
+    }
+    w.put(litCodes[kEndOfBlock], litLens[kEndOfBlock]);
+    w.alignToByte();
+    out.resize(static_cast<std::size_t>(w.end() - out.data()));
+}
+
+void decompress(std::span<const std::uint8_t> in, std::size_t expected, std::vector<std::uint8_t>& out) {
+    if (in.size() < kHeaderBytes) throw VfsException(ErrorCode::Corrupted);
+    std::array<std::uint8_t, kLitLenSymbols> litLens{};
+    std::array<std::uint8_t, kDistSymbols> distLens{};
+    for (std::size_t i = 0; i < kLitLenSymbols + kDistSymbols; ++i) {
+        const std::uint8_t len = (in[i / 2] >> (4 * (i & 1))) & 15;
+        if (i < kLitLenSymbols) litLens[i] = len;
+        else distLens[i - kLitLenSymbols] = len;
+    }
+    std::vector<std::uint16_t> litTable, distTable;
+    buildTable(litLens, litTable);
+    buildTable(distLens, distTable);
+
+    const std::size_t base = out.size();
+    out.resize(base + expected + kCopySlack);
+    std::uint8_t* const start = out.data() + base;
+    std::uint8_t* op = start;
+    std::uint8_t* const oend = start + expected;
+    BitIn bits(in.data() + kHeaderBytes, in.data() + in.size());
+
+    while (true) {
+        if (bits.available() < kMaxSeqBits) bits.refill();
+        const std::uint32_t sym = decodeSymbol(bits, litTable);
+        if (sym < 256) {
+            if (op == oend) throw VfsException(ErrorCode::Corrupted);
+            *op++ = static_cast<std::uint8_t>(sym);
+            continue;
+        }
+        if (sym == kEndOfBlock) break;
+
+        std::uint32_t lenBase = 0, distBase = 0;
+        int lenExtra = 0, distExtra = 0;
+        bucketBase(sym - kFirstLenCode, kLenDirectLog, lenBase, lenExtra);
+        std::size_t len = lenBase + kMinMatch + bits.peek(lenExtra);
+        bits.consume(lenExtra);
+        const std::uint32_t distSym = decodeSymbol(bits, distTable);
+        bucketBase(distSym, kDistDirectLog, distBase, distExtra);
+        const std::size_t offset = distBase + 1 + bits.peek(distExtra);
+        bits.consume(distExtra);
+        if (offset > static_cast<std::size_t>(op - start) || len > static_cast<std::size_t>(oend - op))
+            throw VfsException(ErrorCode::Corrupted);
+
+        const std::uint8_t* match = op - offset;
+        if (offset >= 8) {
+            for (std::size_t k = 0; k < len; k += 8) std::memcpy(op + k, match + k, 8);
+        } else {
+            for (std::size_t k = 0; k < len; ++k) op[k] = match[k];
+        }
+        op += len;
+    }
+    if (op != oend || !bits.exhausted()) throw VfsException(ErrorCode::Corrupted);
+    out.resize(base + expected);
+}
+
+} // namespace lzhuff
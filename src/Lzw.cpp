@@ -0,0 +1,317 @@
+#include "Lzw.hpp"
+#include "Errors.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace lzw {
+
+namespace {
+
+bool isAsciiLetter(std::uint8_t b) {
+    return (b >= 'A' && b <= 'Z') || (b >= 'a' && b <= 'z');
+}
+
+bool validMaxBits(int maxBits) {
+    return maxBits > kMinBits && maxBits <= kMaxWideBits;
+}
+
+// Ключ ячейки кодера (prefix << 8 | byte) + 1 должен уместиться в 32 бита,
+// поэтому при 24 битах последний код не выдаётся.
+std::uint32_t dictLimitFor(int maxBits) {
+    return maxBits < 24 ? 1u << maxBits : (1u << 24) - 1;
+}
+
+// С какой ёмкости начинаются массивы декодера; дальше — удвоение.
+constexpr std::uint32_t kInitialDecoderCodes = 4096;
+
+} // namespace
+
+// ======= Кодер =======
+
+Encoder::Encoder(const Params& params)
+    : alphaOnly_(params.alphaOnly),
+      clearCode_(params.clearCode),
+      maxBits_(params.maxBits),
+      dictLimit_(dictLimitFor(params.maxBits)),
+      firstFree_(params.clearCode ? kClearCode + 1 : kFirstFree),
+      tableBits_(params.maxBits + 1) {
+    if (!validMaxBits(maxBits_)) throw VfsException(ErrorCode::InvalidArg);
+    table_.reset(new Slot[std::size_t{1} << tableBits_]());
+    nextCode_ = firstFree_;
+    // однобайтовые фразы в таблице не храним: их код равен байту
+    if (alphaOnly_) {
+        letters_.resize(dictLimit_, 0);
+        for (int i = 0; i < 256; ++i) letters_[i] = isAsciiLetter(static_cast<std::uint8_t>(i));
+    }
+}
+
+void Encoder::feed(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out) {
+    // Место под худший случай выделяем сразу, в цикле запись идёт без проверок.
+    const std::size_t base = out.size();
+    const std::size_t clears = clearCode_ ? in.size() / kCheckGap + 1 : 0;
+    out.resize(base + 1 + BitWriter::maxBytesFor(in.size(), maxBits_, clears));
+    writer_.begin(out.data() + base);
+    std::size_t i = 0;
+    if (!started_ && !in.empty()) {
+        // поток со сбросом начинается с разрядности
+        if (clearCode_) writer_.put(static_cast<std::uint32_t>(maxBits_), 8);
+        w_ = in[0];
+        started_ = true;
+        i = 1;
+    }
+    const std::uint32_t mask = (1u << tableBits_) - 1;
+    for (; i < in.size(); ++i) {
+        std::uint8_t c = in[i];
+        std::uint32_t key = ((w_ << 8) | c) + 1;
+        std::uint32_t pos = slotOf(key);
+        while (table_[pos].key != kEmpty && table_[pos].key != key) pos = (pos + 1) & mask;
+
+        if (table_[pos].key == key) {
+            // Фраза расширяется
+            w_ = table_[pos].code;
+            continue;
+        }
+
+        writer_.put(w_, codeBits_);
+
+        // Разрядность растёт сразу после вывода кода, как только следующий свободный
+        // код в неё не помещается — независимо от того, будет ли добавление:
+        // декодер ещё не знает c и должен принять то же решение без него.
+        if (nextCode_ < dictLimit_) {
+            if (nextCode_ == (1u << codeBits_) && codeBits_ < maxBits_) {
+                ++codeBits_;
+                writer_.alignToByte();
+            }
+            // ALL: добавляем всегда, пока есть место; ALPHA: только фразы из букв.
+            // pos — свободная ячейка, на которой остановился поиск.
+            if (!alphaOnly_ || (letters_[w_] && isAsciiLetter(c))) {
+                if (alphaOnly_) letters_[nextCode_] = 1;
+                table_[pos] = Slot{key, nextCode_++};
+                used_.push_back(pos);
+            }
+        } else if (clearCode_) {
+            bitsSinceFull_ += static_cast<std::uint64_t>(codeBits_);
+            if (ratioDropped(fed_ + i)) {
+                // c начнёт новый словарь так же, как первый байт потока
+                writer_.put(kClearCode, codeBits_);
+                writer_.alignToByte();
+                restartDictionary();
+            }
+        }
+        w_ = c;
+    }
+    fed_ += in.size();
+    out.resize(static_cast<std::size_t>(writer_.end() - out.data()));
+}
+
+bool Encoder::ratioDropped(std::uint64_t pos) noexcept {
+    if (!full_) {
+        full_ = true;
+        fullAt_ = pos;
+        nextCheck_ = pos + kCheckGap;
+        bitsSinceFull_ = 0;
+        bestRatio_ = 0;
+        return false;
+    }
+    if (pos < nextCheck_) return false;
+    // Как в compress(1): степень сжатия с момента заполнения словаря (в 1/256 бита
+    // на бит) сравнивается с лучшей из прошлых проверок; падение — словарь устарел.
+    const std::uint64_t ratio = ((pos - fullAt_) * 8 * 256) / std::max<std::uint64_t>(1, bitsSinceFull_);
+    nextCheck_ = pos + kCheckGap;
+    if (ratio >= bestRatio_) {
+        bestRatio_ = ratio;
+        return false;
+    }
+    return true;
+}
+
+void Encoder::restartDictionary() noexcept {
+    for (std::uint32_t pos : used_) table_[pos] = Slot{kEmpty, 0};
+    used_.clear();
+    nextCode_ = firstFree_;
+    codeBits_ = kMinBits;
+    full_ = false;
+}
+
+void Encoder::finish(std::vector<std::uint8_t>& out) {
+    const std::size_t base = out.size();
+    out.resize(base + BitWriter::maxBytesFor(1, maxBits_));
+    writer_.begin(out.data() + base);
+    if (started_) writer_.put(w_, codeBits_);
+    writer_.alignToByte();
+    out.resize(static_cast<std::size_t>(writer_.end() - out.data()));
+}
+
+void Encoder::reset() {
+    restartDictionary();
+    w_ = 0;
+    started_ = false;
+    writer_ = BitWriter{};
+    fed_ = 0;
+}
+
+// ======= Декодер =======
+
+Decoder::Decoder(const Params& params)
+    : alphaOnly_(params.alphaOnly),
+      clearCode_(params.clearCode),
+      haveMaxBits_(!params.clearCode),
+      bitsLimit_(params.maxBits),
+      firstFree_(params.clearCode ? kClearCode + 1 : kFirstFree) {
+    if (!validMaxBits(params.maxBits)) throw VfsException(ErrorCode::InvalidArg);
+    nextCode_ = firstFree_;
+    // в режиме со сбросом словарь выделяется по заголовку потока
+    if (!clearCode_) setMaxBits(params.maxBits);
+}
+
+void Decoder::setMaxBits(int maxBits) {
+    // байт разрядности пришёл из потока: до проверки ничего под него не выделяем
+    if (!validMaxBits(maxBits) || maxBits > bitsLimit_) throw VfsException(ErrorCode::Corrupted);
+    maxBits_ = maxBits;
+    dictLimit_ = dictLimitFor(maxBits);
+    if (!link_.empty()) return;
+    grow();
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        link_[i] = i;
+        length_[i] = 1;
+        first_[i] = static_cast<std::uint8_t>(i);
+        letters_[i] = isAsciiLetter(static_cast<std::uint8_t>(i));
+    }
+}
+
+void Decoder::grow() {
+    const std::size_t capacity = link_.empty()
+        ? kInitialDecoderCodes : std::min<std::size_t>(2 * link_.size(), dictLimit_);
+    link_.resize(capacity);
+    length_.resize(capacity);
+    first_.resize(capacity);
+    letters_.resize(capacity);
+    start_.resize(capacity);
+}
+
+void Decoder::feed(std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out) {
+    if (!haveMaxBits_ && !in.empty()) {
+        setMaxBits(in[0]);
+        haveMaxBits_ = true;
+        in = in.subspan(1);
+    }
+    if (!in.empty()) sawInput_ = true;
+    // out может содержать хвост уже выданного вывода — это окно для копирования фраз
+    windowBase_ = produced_ - std::min<std::uint64_t>(produced_, out.size());
+    const std::uint8_t* p = in.data();
+    const std::uint8_t* const end = p + in.size();
+    std::uint32_t code = 0;
+    while (true) {
+        // Основная часть потока — словами без проверок, последние байты — по одному.
+        if (end - p >= 8) {
+            p += reader_.refill(p);
+        } else {
+            while (p < end && reader_.canPush()) reader_.push(*p++);
+        }
+        while (reader_.get(codeBits_, code)) onCode(code, out);
+        if (p == end) break;
+    }
+}
+
+void Decoder::finish() {
+    // остаток короче кода — выравнивание в конце потока
+    if (sawInput_ && !started_) throw VfsException(ErrorCode::Corrupted);
+}
+
+void Decoder::reset() {
+    produced_ = 0;
+    windowBase_ = 0;
+    prevStart_ = 0;
+    prev_ = 0;
+    sawInput_ = false;
+    haveMaxBits_ = !clearCode_;
+    restartDictionary();
+    reader_ = BitReader{};
+}
+
+void Decoder::restartDictionary() noexcept {
+    // записи прежнего словаря перезапишутся раньше, чем будут прочитаны
+    started_ = false;
+    nextCode_ = firstFree_;
+    codeBits_ = kMinBits;
+}
+
+void Decoder::emit(std::uint32_t code, std::vector<std::uint8_t>& out) {
+    std::size_t len = length_[code];
+    std::size_t base = out.size();
+    prevStart_ = produced_;
+    produced_ += len;
+    out.resize(base + len);
+    std::uint8_t* p = out.data() + base + len;
+    if (code >= 256 && start_[code] >= windowBase_) {
+        // фраза ещё в окне — простое копирование вместо обхода цепочки
+        std::memcpy(out.data() + base, out.data() + (start_[code] - windowBase_), len);
+        return;
+    }
+    // Цепочка префиксов идёт от последнего байта к первому — заполняем с конца.
+    while (code >= 256) {
+        std::uint32_t link = link_[code];
+        *--p = static_cast<std::uint8_t>(link);
+        code = link >> 8;
+    }
+    *--p = static_cast<std::uint8_t>(code);
+}
+
+void Decoder::onCode(std::uint32_t code, std::vector<std::uint8_t>& out) {
+    if (!started_) {
+        if (code >= 256u) throw VfsException(ErrorCode::Corrupted);
+        out.push_back(static_cast<std::uint8_t>(code));
+        prevStart_ = produced_++;
+        prev_ = code;
+        started_ = true;
+        widenIfNeeded();
+        return;
+    }
+
+    if (clearCode_ && code == kClearCode) {
+        reader_.alignToByte();
+        restartDictionary();
+        return;
+    }
+
+    // prev + first(entry) лежит в выводе подряд, начиная с начала фразы prev
+    const std::uint64_t prevStart = prevStart_;
+    std::uint8_t entryFirst;
+    if (code < nextCode_) {
+        emit(code, out);
+        entryFirst = first_[code];
+    } else if (code == nextCode_) {
+        // «Квирк» LZW: K = prev + first(prev)
+        entryFirst = first_[prev_];
+        emit(prev_, out);
+        out.push_back(entryFirst);
+        ++produced_;
+    } else {
+        throw VfsException(ErrorCode::Corrupted);
+    }
+
+    // Политика добавления в словарь зеркалит кодер: новая запись — prev + first(entry).
+    if (nextCode_ < dictLimit_ && (!alphaOnly_ || (letters_[prev_] && isAsciiLetter(entryFirst)))) {
+        if (nextCode_ == link_.size()) grow();
+        link_[nextCode_] = (prev_ << 8) | entryFirst;
+        first_[nextCode_] = first_[prev_];
+        length_[nextCode_] = length_[prev_] + 1;
+        letters_[nextCode_] = 1;
+        start_[nextCode_] = prevStart;
+        ++nextCode_;
+    }
+    prev_ = code;
+    widenIfNeeded();
+}
+
+void Decoder::widenIfNeeded() {
+    // Зеркало кодера: после кода с номером j в словаре столько же записей, сколько
+    // было у кодера перед его расширением, так что следующий код читаем уже шире.
+    if (nextCode_ < dictLimit_ && nextCode_ == (1u << codeBits_) && codeBits_ < maxBits_) {
+        ++codeBits_;
+        reader_.alignToByte();
+    }
+}
+
+} // namespace lzw
@@ -5,8 +5,8 @@
 #include <cstring>
 #include <vector>
 
-OIStream::OIStream(FileContent& file, StreamMode mode, std::size_t bufSize)
-    : file_(file), mode_(mode), bufCapacity_(bufSize) {
+OIStream::OIStream(FileContent& file, StreamMode mode, std::size_t bufSize, DictionaryLookup dicts)
+    : file_(file), mode_(mode), bufCapacity_(bufSize), dicts_(std::move(dicts)) {
     if (bufSize == 0) throw VfsException(ErrorCode::InvalidArg);
 }
 
@@ -19,6 +19,7 @@ void OIStream::Open() {
     dirty_ = false;
     eof_ = false;
     role_ = BufferRole::Idle;
+    if (mode_ == StreamMode::ReadDecompressed) decomp_ = std::make_unique<DecompressReader>(file_, dicts_);
     opened_ = true;
 
     if (canRead()) {
@@ -36,6 +37,7 @@ void OIStream::Close() {
     dirty_ = false;
     eof_ = false;
     role_ = BufferRole::Idle;
+    decomp_.reset();
 }
 
 bool OIStream::ReadByte(std::uint8_t& out) {
@@ -162,6 +164,7 @@ std::size_t OIStream::Seek(std::size_t newPos) {
     bufSizeUsed_ = 0;
     eof_ = false;
     role_ = BufferRole::Idle;
+    if (decomp_) decomp_->seek(newPos);
 
     if (canRead()) {
         fillBufferForRead(newPos);
@@ -182,6 +185,15 @@ bool OIStream::Eof() const noexcept {
 
 void OIStream::fillBufferForRead(std::size_t filePos) {
     if (!canRead()) return;
+    if (decomp_) {
+        // распаковка идёт строго подряд, filePos — следующая позиция в распакованных данных
+        bufFilePos_ = filePos;
+        bufSizeUsed_ = decomp_->read(std::span<std::uint8_t>(buffer_.data(), bufCapacity_));
+        bufPos_ = 0;
+        eof_ = bufSizeUsed_ == 0;
+        role_ = BufferRole::Read;
+        return;
+    }
     std::size_t fileSize = file_.size();
     bufFilePos_ = filePos;
     if (filePos >= fileSize) {
@@ -192,9 +204,7 @@ void OIStream::fillBufferForRead(std::size_t filePos) {
         return;
     }
     std::size_t toRead = std::min(bufCapacity_, fileSize - filePos);
-    auto data = file_.read(filePos, toRead);
-    std::copy(data.begin(), data.end(), buffer_.begin());
-    bufSizeUsed_ = data.size();
+    bufSizeUsed_ = file_.readInto(filePos, std::span<std::uint8_t>(buffer_.data(), toRead));
     bufPos_ = 0;
     eof_ = false;
     role_ = BufferRole::Read;
@@ -202,8 +212,7 @@ void OIStream::fillBufferForRead(std::size_t filePos) {
 
 void OIStream::flushBufferForWrite() {
     if (!dirty_) return;
-    std::vector<std::uint8_t> chunk(buffer_.begin(), buffer_.begin() + bufSizeUsed_);
-    file_.write(bufFilePos_, chunk);
+    file_.write(bufFilePos_, std::span<const std::uint8_t>(buffer_.data(), bufSizeUsed_));
     bufFilePos_ += bufSizeUsed_;
     bufPos_ = 0;
     bufSizeUsed_ = 0;
@@ -224,7 +233,8 @@ void OIStream::ensureModeWrite() const {
 }
 
 bool OIStream::canRead() const noexcept {
-    return mode_ == StreamMode::ReadOnly || mode_ == StreamMode::ReadWrite;
+    return mode_ == StreamMode::ReadOnly || mode_ == StreamMode::ReadWrite ||
+           mode_ == StreamMode::ReadDecompressed;
 }
 
 bool OIStream::canWrite() const noexcept {
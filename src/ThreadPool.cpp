@@ -0,0 +1,100 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Поток сейчас выполняет задачу какого-то пула: вложенный цикл — на месте.
+thread_local bool tInJob = false;
+
+struct JobScope {
+    bool prev = std::exchange(tInJob, true);
+    ~JobScope() { tInJob = prev; }
+};
+
+} // namespace
+
+unsigned ThreadPool::defaultThreads() noexcept {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(0);
+    return pool;
+}
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = defaultThreads();
+    workers_.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; ++i) workers_.emplace_back([this, i]{ workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lk(mu_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : workers_) t.join();
+}
+
+void ThreadPool::parallelFor(std::size_t n, const Job& fn, unsigned limit) {
+    if (n == 0) return;
+    const unsigned active = limit ? std::min(limit, size()) : size();
+    if (active == 1 || n == 1 || tInJob) {
+        for (std::size_t i = 0; i < n; ++i) fn(i, 0);
+        return;
+    }
+    std::lock_guard call(callMu_);
+    {
+        std::lock_guard lk(mu_);
+        job_ = &fn;
+        jobSize_ = n;
+        active_ = active;
+        next_.store(0, std::memory_order_relaxed);
+        error_ = nullptr;
+        // каждый рабочий отмечается в каждом поколении, даже если работы ему не досталось:
+        // иначе опоздавший поток мог бы взять job_ уже после возврата
+        busy_ = static_cast<unsigned>(workers_.size());
+        ++generation_;
+    }
+    wake_.notify_all();
+    runJob(0);
+
+    std::unique_lock lk(mu_);
+    done_.wait(lk, [&]{ return busy_ == 0; });
+    job_ = nullptr;
+    if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+}
+
+void ThreadPool::workerLoop(unsigned worker) {
+    std::uint64_t seen = 0;
+    while (true) {
+        bool take = false;
+        {
+            std::unique_lock lk(mu_);
+            wake_.wait(lk, [&]{ return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+            take = worker < active_;
+        }
+        if (take) runJob(worker);
+        std::lock_guard lk(mu_);
+        if (--busy_ == 0) done_.notify_one();
+    }
+}
+
+void ThreadPool::runJob(unsigned worker) {
+    JobScope scope;
+    for (std::size_t i; (i = next_.fetch_add(1, std::memory_order_relaxed)) < jobSize_; ) {
+        try {
+            (*job_)(i, worker);
+        } catch (...) {
+            std::lock_guard lk(mu_);
+            if (!error_) error_ = std::current_exception();
+            next_.store(jobSize_, std::memory_order_relaxed);
+        }
+    }
+}
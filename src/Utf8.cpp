@@ -0,0 +1,65 @@
+#include "Utf8.hpp"
+
+#include <bit>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Utf8 {
+
+namespace {
+
+// Скалярный хвост: байт-продолжение имеет вид 10xxxxxx.
+std::size_t countTail(const std::uint8_t* p, std::size_t n) noexcept {
+    std::size_t cnt = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        cnt += (p[i] & 0xC0u) != 0x80u;
+    return cnt;
+}
+
+// SWAR по 8 байт: старший бит выставлен, а следующий за ним сброшен.
+std::size_t countWords(const std::uint8_t* p, std::size_t words) noexcept {
+    constexpr std::uint64_t kHigh = 0x8080808080808080ull;
+    std::size_t cnt = 0;
+    for (std::size_t i = 0; i < words; ++i) {
+        std::uint64_t w;
+        std::memcpy(&w, p + i * 8, sizeof(w));
+        std::uint64_t cont = w & ~(w << 1) & kHigh;
+        cnt += 8 - static_cast<std::size_t>(std::popcount(cont));
+    }
+    return cnt;
+}
+
+}
+
+std::size_t countCodePoints(const std::uint8_t* data, std::size_t n) noexcept {
+    if (!data || n == 0) return 0;
+    std::size_t cnt = 0;
+    std::size_t i = 0;
+#if defined(__AVX2__)
+    // 0x80..0xBF как знаковые — это [-128, -65]; всё, что больше -65, — начало символа.
+    const __m256i limit = _mm256_set1_epi8(-65);
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, limit)));
+        cnt += static_cast<std::size_t>(std::popcount(mask));
+    }
+#elif defined(__SSE2__)
+    const __m128i limit = _mm_set1_epi8(-65);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(v, limit)));
+        cnt += static_cast<std::size_t>(std::popcount(mask));
+    }
+#endif
+    std::size_t words = (n - i) / 8;
+    cnt += countWords(data + i, words);
+    i += words * 8;
+    return cnt + countTail(data + i, n - i);
+}
+
+}
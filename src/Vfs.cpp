@@ -2,10 +2,18 @@
 #include "Path.hpp"
 #include "JsonIO.hpp"
 #include "Compression.hpp"
+#include "Utf8.hpp"
+#include "HostFile.hpp"
+#include "ThreadPool.hpp"
+#include "DictTrainer.hpp"
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <cstdio>
 #include <ctime>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include "FileContent.hpp"
 
 namespace {
@@ -27,6 +35,26 @@ NodePtr pickChild(const FSNode::ChildSet& entry, Vfs::ResolveKind pref) {
     }
 }
 
+void copySubtreeTotals(const NodePtr& dst, const NodePtr& src) {
+    dst->fileProps.byteSize = src->fileProps.byteSize;
+    dst->fileProps.charCount = src->fileProps.charCount;
+    dst->fileProps.fileCount = src->fileProps.fileCount;
+    dst->fileProps.dirCount = src->fileProps.dirCount;
+}
+
+std::string dictionaryName(std::uint32_t id) {
+    char name[16];
+    std::snprintf(name, sizeof(name), "%08x", id);
+    return name;
+}
+
+std::string dictionaryPath(std::uint32_t id) {
+    return std::string(Vfs::kDictDir) + "/" + dictionaryName(id);
+}
+
+// Обучению хватает начала корпуса: дальше словарь почти не меняется.
+constexpr std::size_t kMaxTrainingBytes = 32u << 20;
+
 template<class Fn>
 void forEachChild(const NodePtr& parent, Fn&& fn) {
     if (!parent) return;
@@ -38,7 +66,7 @@ void forEachChild(const NodePtr& parent, Fn&& fn) {
 
 }
 
-Vfs::Vfs() : nameIndex_(7) {
+Vfs::Vfs() : nameIndex_(7), cache_(std::make_unique<DecompressCache>()) {
     root_ = std::make_shared<FSNode>("/", false);
     cwd_  = root_;
     initNodeProps(root_);
@@ -74,6 +102,7 @@ std::shared_ptr<FSNode> Vfs::resolve(const std::string& path, ResolveKind prefer
             if (auto p = cur->parent.lock()) cur = p;
             continue;
         }
+        materialize(cur);
         auto it = cur->children.find(name);
         if (it==cur->children.end()) return nullptr;
         bool last = (i+1 == parts.size());
@@ -123,12 +152,14 @@ void Vfs::mkdir(const std::string& path) {
     if (parent->isFile)      throw VfsException(ErrorCode::InvalidArg);
     if (name.empty() || name=="." || name==".." || name.find('/')!=std::string::npos)
         throw VfsException(ErrorCode::InvalidArg);
+    unpinForWrite(parent);
     std::string finalName = parent->hasChild(name, false) ? makeUniqueName(parent, name, false) : name;
     auto dir = std::make_shared<FSNode>(finalName, false);
     dir->parent = parent;
     parent->setChild(dir);
     initNodeProps(dir);
     indexInsert(dir);
+    propagateStats(parent, subtreeTotals(dir));
     touchNode(parent);
 }
 
@@ -140,12 +171,14 @@ void Vfs::createFile(const std::string& path) {
     if (parent->isFile) throw VfsException(ErrorCode::InvalidArg);
     if (name.empty() || name=="." || name==".." || name.find('/')!=std::string::npos)
         throw VfsException(ErrorCode::InvalidArg);
+    unpinForWrite(parent);
     std::string finalName = parent->hasChild(name, true) ? makeUniqueName(parent, name, true) : name;
     auto f = std::make_shared<FSNode>(finalName, true);
     f->parent = parent;
     parent->setChild(f);
     initNodeProps(f);
     indexInsert(f);
+    propagateStats(parent, subtreeTotals(f));
     touchNode(parent);
 }
 
@@ -159,6 +192,7 @@ void Vfs::renameNode(const std::string& path, const std::string& newName) {
     auto p = n->parent.lock();
     if (!p)            throw VfsException(ErrorCode::PathError);
     if (newName == n->name) return;
+    unpinForWrite(p);
     if (p->hasChild(newName, n->isFile)) throw VfsException(ErrorCode::InvalidArg);
 
     indexErase(n);
@@ -182,16 +216,21 @@ void Vfs::mv(const std::string& src, const std::string& dstDir) {
 
     auto p = node->parent.lock();
     if (!p) throw VfsException(ErrorCode::PathError);
+    unpinForWrite(p);
+    unpinForWrite(dst);
     if (dst->hasChild(node->name, node->isFile)) throw VfsException(ErrorCode::InvalidArg);
 
+    auto totals = subtreeTotals(node);
     p->removeChild(node->name, node->isFile);
+    propagateStats(p, totals, -1);
     node->parent = dst;
     dst->setChild(node);
+    propagateStats(dst, totals);
     touchNode(p);
     touchNode(dst);
 }
 
-void Vfs::cp(const std::string& srcPath, const std::string& dstPath) {
+void Vfs::cp(const std::string& srcPath, const std::string& dstPath, CopyMode mode) {
     auto src = resolve(srcPath);
     if (!src) throw VfsException(ErrorCode::PathError);
     if (src == root_) throw VfsException(ErrorCode::RootError);
@@ -226,8 +265,22 @@ void Vfs::cp(const std::string& srcPath, const std::string& dstPath) {
     if (!src->isFile && isSubtreeOf(targetDir, src))
         throw VfsException(ErrorCode::Conflict);
 
+    unpinForWrite(targetDir);
     auto finalName = makeUniqueName(targetDir, desiredName, src->isFile);
-    copyNodeRec(src, targetDir, finalName);
+    NodePtr clone;
+    if (mode == CopyMode::Lazy && !src->isFile) {
+        clone = std::make_shared<FSNode>(finalName, false);
+        clone->parent = targetDir;
+        clone->compression = src->compression;
+        targetDir->setChild(clone);
+        initNodeProps(clone);
+        indexInsert(clone);
+        attachLazy(clone, src);
+        copySubtreeTotals(clone, src);
+    } else {
+        clone = copyNodeRec(src, targetDir, finalName);
+    }
+    propagateStats(targetDir, subtreeTotals(clone));
     touchNode(targetDir);
 }
 
@@ -237,9 +290,11 @@ void Vfs::rm(const std::string& path) {
     if (node==root_) throw VfsException(ErrorCode::RootError);
     auto p = node->parent.lock();
     if (!p) throw VfsException(ErrorCode::PathError);
+    unpinForWrite(p);
 
     indexEraseSubtree(node);
     p->removeChild(node->name, node->isFile);
+    propagateStats(p, subtreeTotals(node), -1);
     touchNode(p);
 }
 
@@ -247,16 +302,21 @@ void Vfs::ls(const std::string& path) const {
     auto n = path.empty() ? cwd_ : resolve(path, ResolveKind::Directory);
     if (!n)         throw VfsException(ErrorCode::PathError);
     if (n->isFile)  throw VfsException(ErrorCode::InvalidArg);
+    materialize(n);
     for (auto& [name, bucket] : n->children) {
         if (bucket.dir)  std::cout << "  📁 " << name << "/\n";
         if (bucket.file) std::cout << "  📄 " << name << "\n";
     }
 }
 
-void Vfs::printTree() const { printTreeRec(root_, 0); }
+void Vfs::printTree() const {
+    materializeAll();
+    printTreeRec(root_, 0);
+}
 
 std::vector<Vfs::NodePtr> Vfs::findNodesByName(const std::string& name) const {
     std::vector<NodePtr> out;
+    materializeAll();
     auto opt = nameIndex_.find(name);
     if (!opt) return out;
     auto bucket = *opt;
@@ -267,6 +327,88 @@ std::vector<Vfs::NodePtr> Vfs::findNodesByName(const std::string& name) const {
     return out;
 }
 
+void Vfs::setDedup(bool enabled) {
+    if (!enabled) { blobStore_.reset(); return; }
+    if (blobStore_) return;
+    blobStore_ = std::make_unique<BlobStore>();
+    materializeAll();
+    std::vector<NodePtr> stack{root_};
+    while (!stack.empty()) {
+        auto n = std::move(stack.back());
+        stack.pop_back();
+        if (n->isFile) n->content.intern(*blobStore_);
+        else forEachChild(n, [&](const NodePtr& child){ stack.push_back(child); });
+    }
+}
+
+void Vfs::setCountCodePoints(bool enabled) {
+    if (countCodePoints_ == enabled) return;
+    countCodePoints_ = enabled;
+    materializeAll();
+    std::vector<NodePtr> stack{root_};
+    while (!stack.empty()) {
+        auto n = std::move(stack.back());
+        stack.pop_back();
+        if (n->isFile) recountFileStats(n);
+        else forEachChild(n, [&](const NodePtr& child){ stack.push_back(child); });
+    }
+}
+
+Vfs::DedupStats Vfs::dedupStats() const {
+    // Логический объём берём из агрегатов корня; физический — по уникальным буферам.
+    // Ленивые копии физически ничего не добавляют, поэтому их не раскрываем.
+    DedupStats st;
+    st.files = root_->fileProps.fileCount;
+    st.logicalBytes = root_->fileProps.byteSize;
+    std::unordered_set<const void*> seen;
+    std::vector<NodePtr> stack{root_};
+    while (!stack.empty()) {
+        auto n = std::move(stack.back());
+        stack.pop_back();
+        if (n->isFile) {
+            n->content.forEachStorageBlock([&](const void* id, std::size_t bytes) {
+                if (!seen.insert(id).second) return;
+                st.physicalBytes += bytes;
+                ++st.blobs;
+            });
+        } else {
+            forEachChild(n, [&](const NodePtr& child){ stack.push_back(child); });
+        }
+    }
+    return st;
+}
+
+std::size_t Vfs::nodeMemory(const FSNode& node) noexcept {
+    // Узел под make_shared, имя вне SSO, узлы карты детей; содержимое файла — отдельно.
+    using MapNode = std::pair<const std::string, FSNode::ChildSet>;
+    std::size_t bytes = sizeof(FSNode) + 2 * sizeof(void*);
+    if (node.name.capacity() > std::string().capacity()) bytes += node.name.capacity() + 1;
+    bytes += node.children.size() * (sizeof(MapNode) + 4 * sizeof(void*));
+    bytes += node.lazyClones.capacity() * sizeof(WNodePtr);
+    return bytes;
+}
+
+Vfs::MemoryStats Vfs::memoryUsage(const std::string& path) const {
+    NodePtr start = path.empty() ? root_ : resolve(path);
+    if (!start) throw VfsException(ErrorCode::PathError);
+    if (!start->isFile) materializeAll();
+    MemoryStats st;
+    std::vector<NodePtr> stack{start};
+    while (!stack.empty()) {
+        auto n = std::move(stack.back());
+        stack.pop_back();
+        ++st.nodes;
+        st.nodeBytes += nodeMemory(*n);
+        if (n->isFile) {
+            st.contentBytes += n->content.heapBytes();
+            if (n->content.isInline()) ++st.inlineFiles;
+        } else {
+            forEachChild(n, [&](const NodePtr& child){ stack.push_back(child); });
+        }
+    }
+    return st;
+}
+
 void Vfs::saveJson(const std::string& jsonPath) {
     if (jsonPath.empty()) throw VfsException(ErrorCode::InvalidArg);
     std::string leaf;
@@ -276,6 +418,8 @@ void Vfs::saveJson(const std::string& jsonPath) {
     if (leaf.empty() || leaf=="." || leaf==".." || leaf.find('/')!=std::string::npos)
         throw VfsException(ErrorCode::InvalidArg);
 
+    materializeAll();
+    unpinForWrite(parent);
     NodePtr target = parent->getChild(leaf, true);
     if (!target) {
         target = std::make_shared<FSNode>(leaf, true);
@@ -283,11 +427,13 @@ void Vfs::saveJson(const std::string& jsonPath) {
         parent->setChild(target);
         initNodeProps(target);
         indexInsert(target);
+        propagateStats(parent, subtreeTotals(target));
         touchNode(parent);
     }
 
     auto json = JsonIO::treeToJson(root_);
     target->content.assignText(json);
+    recountFileStats(target);
     touchNode(target);
 }
 
@@ -347,41 +493,65 @@ std::string Vfs::makeUniqueName(const NodePtr& parent, const std::string& base,
 Vfs::NodePtr Vfs::copyNodeRec(const NodePtr& src, const NodePtr& destParent, const std::string& name) {
     auto clone = std::make_shared<FSNode>(name, src->isFile);
     clone->parent = destParent;
-    if (clone->isFile) {
-        clone->content.replaceAll(src->content.bytes());
-    }
     destParent->setChild(clone);
     touchNode(destParent);
     initNodeProps(clone);
+    if (clone->isFile) clone->content = src->content;
+    else               clone->compression = src->compression;
     indexInsert(clone);
     if (!clone->isFile) {
+        materialize(src);
         forEachChild(src, [&](const NodePtr& child) {
             copyNodeRec(child, clone, child->name);
         });
     }
+    // копия поддерева имеет те же агрегаты; наверх их переносит вызывающий
+    copySubtreeTotals(clone, src);
     return clone;
 }
 
-void Vfs::compressNode(const NodePtr& node) {
-    if (!node) return;
-    if (node->isFile) {
-        compressInplace(node->content, CompAlgo::LZW_VAR_ALL);
-        touchNode(node);
-        return;
+std::vector<Vfs::NodePtr> Vfs::collectFilesForWrite(const NodePtr& node) const {
+    // Обход последовательный: материализация ленивых копий меняет дерево.
+    std::vector<NodePtr> files;
+    std::vector<NodePtr> stack{node};
+    while (!stack.empty()) {
+        auto n = std::move(stack.back());
+        stack.pop_back();
+        if (n->isFile) { files.push_back(std::move(n)); continue; }
+        materialize(n);
+        releasePins(n);
+        forEachChild(n, [&](const NodePtr& child){ stack.push_back(child); });
     }
-    forEachChild(node, [&](const NodePtr& child){ compressNode(child); });
-}
-
-void Vfs::decompressNode(const NodePtr& node) {
-    if (!node) return;
-    if (node->isFile) {
-        if (isCompressed(node->content)) {
-            uncompressInplace(node->content);
-            touchNode(node);
-        }
-        return;
+    return files;
+}
+
+void Vfs::transformFiles(const std::vector<NodePtr>& files, unsigned threads,
+                         const std::function<bool(FileContent&, unsigned)>& fn) {
+    // Большие файлы идут по одному, их блоки параллелит сам кодек; мелкие —
+    // по файлу на поток, крупные из них первыми, чтобы в конце не ждать одного.
+    std::vector<NodePtr> small, large;
+    for (const auto& f : files) (f->content.size() > kCompressBlock ? large : small).push_back(f);
+    std::sort(small.begin(), small.end(), [](const NodePtr& a, const NodePtr& b) {
+        return a->content.size() > b->content.size();
+    });
+
+    for (const auto& f : large) {
+        if (!fn(f->content, threads)) continue;
+        recountFileStats(f);
+        touchNode(f);
     }
-    forEachChild(node, [&](const NodePtr& child){ decompressNode(child); });
+
+    // Агрегаты каталогов общие для всех файлов — их обновление под замком,
+    // а подсчёт символов (проход по содержимому) — ещё в рабочем потоке.
+    std::mutex statsMu;
+    ThreadPool::shared().parallelFor(small.size(), [&](std::size_t i, unsigned) {
+        const auto& f = small[i];
+        if (!fn(f->content, 1)) return;
+        const std::size_t chars = countChars(f->content);
+        std::lock_guard lk(statsMu);
+        applyFileStats(f, f->content.size(), chars);
+        touchNode(f);
+    }, threads);
 }
 
 void Vfs::initNodeProps(const NodePtr& node) {
@@ -389,30 +559,148 @@ void Vfs::initNodeProps(const NodePtr& node) {
     auto now = std::time(nullptr);
     node->fileProps.createdAt = now;
     node->fileProps.modifiedAt = now;
-    if (node->isFile) {
-        node->fileProps.byteSize = node->content.size();
-        node->fileProps.charCount = node->content.asText().size();
-    } else {
-        node->fileProps.byteSize = 0;
-        node->fileProps.charCount = 0;
-    }
+    node->fileProps.byteSize = 0;
+    node->fileProps.charCount = 0;
+    node->fileProps.fileCount = 0;
+    node->fileProps.dirCount = 0;
+    if (node->isFile) recountFileStats(node);
 }
 
 void Vfs::touchNode(const NodePtr& node) {
     if (!node) return;
+    if (node->isFile) cache_->invalidate(node.get());
+    if (node->isFile && inDictionaryDir(node)) dictionaries_.clear();
     auto now = std::time(nullptr);
     if (node->fileProps.createdAt == 0) node->fileProps.createdAt = now;
     node->fileProps.modifiedAt = now;
+}
+
+void Vfs::recountFileStats(const NodePtr& node) {
+    if (!node || !node->isFile) return;
+    applyFileStats(node, node->content.size(), countChars(node->content));
+}
+
+std::size_t Vfs::countChars(const FileContent& content) const {
+    if (!countCodePoints_) return content.size();
+    std::size_t chars = 0;
+    content.forEachChunk([&](const std::uint8_t* p, std::size_t n) {
+        chars += Utf8::countCodePoints(p, n);
+    });
+    return chars;
+}
+
+void Vfs::applyFileStats(const NodePtr& node, std::size_t size, std::size_t chars) {
+    StatsDelta d;
+    d.bytes = static_cast<std::int64_t>(size) - static_cast<std::int64_t>(node->fileProps.byteSize);
+    d.chars = static_cast<std::int64_t>(chars) - static_cast<std::int64_t>(node->fileProps.charCount);
+    node->fileProps.byteSize = size;
+    node->fileProps.charCount = chars;
+    propagateStats(node->parent.lock(), d);
+    // Полный пересчёт идёт после записи всего содержимого — тут же и дедуплицируем.
+    if (blobStore_) node->content.intern(*blobStore_);
+}
+
+void Vfs::accountAppend(const NodePtr& node, const std::uint8_t* data, std::size_t n) {
+    if (!node || !node->isFile) return;
+    StatsDelta d;
+    d.bytes = static_cast<std::int64_t>(n);
+    d.chars = static_cast<std::int64_t>(countCodePoints_ ? Utf8::countCodePoints(data, n) : n);
+    node->fileProps.byteSize += n;
+    node->fileProps.charCount += static_cast<std::size_t>(d.chars);
+    propagateStats(node->parent.lock(), d);
+}
+
+Vfs::StatsDelta Vfs::subtreeTotals(const NodePtr& node) {
+    StatsDelta d;
+    if (!node) return d;
+    d.bytes = static_cast<std::int64_t>(node->fileProps.byteSize);
+    d.chars = static_cast<std::int64_t>(node->fileProps.charCount);
     if (node->isFile) {
-        node->fileProps.byteSize = node->content.size();
-        node->fileProps.charCount = node->content.asText().size();
+        d.files = 1;
     } else {
-        node->fileProps.byteSize = 0;
-        node->fileProps.charCount = 0;
+        d.files = static_cast<std::int64_t>(node->fileProps.fileCount);
+        d.dirs = static_cast<std::int64_t>(node->fileProps.dirCount) + 1;
+    }
+    return d;
+}
+
+void Vfs::propagateStats(const NodePtr& dir, const StatsDelta& d, int sign) {
+    auto apply = [sign](std::size_t& v, std::int64_t delta) {
+        v = static_cast<std::size_t>(static_cast<std::int64_t>(v) + sign * delta);
+    };
+    for (auto cur = dir; cur; cur = cur->parent.lock()) {
+        apply(cur->fileProps.byteSize, d.bytes);
+        apply(cur->fileProps.charCount, d.chars);
+        apply(cur->fileProps.fileCount, d.files);
+        apply(cur->fileProps.dirCount, d.dirs);
+    }
+}
+
+void Vfs::attachLazy(const NodePtr& clone, const NodePtr& source) const {
+    // Источником всегда служит материализованная директория.
+    auto origin = source->lazySource ? source->lazySource : source;
+    clone->lazySource = origin;
+    origin->lazyClones.push_back(clone);
+    lazyDirs_.push_back(clone);
+}
+
+void Vfs::materialize(const NodePtr& dir) const {
+    if (!dir || !dir->lazySource) return;
+    auto src = std::move(dir->lazySource);
+    dir->lazySource.reset();
+    auto& pending = src->lazyClones;
+    pending.erase(std::remove_if(pending.begin(), pending.end(), [&](const WNodePtr& w){
+        auto sp = w.lock();
+        return !sp || sp == dir;
+    }), pending.end());
+
+    auto now = std::time(nullptr);
+    forEachChild(src, [&](const NodePtr& child) {
+        auto clone = std::make_shared<FSNode>(child->name, child->isFile);
+        clone->parent = dir;
+        clone->fileProps = child->fileProps;
+        clone->fileProps.createdAt = now;
+        clone->fileProps.modifiedAt = now;
+        if (child->isFile) {
+            clone->content = child->content;
+        } else {
+            clone->compression = child->compression;
+            attachLazy(clone, child);
+        }
+        dir->setChild(clone);
+        indexInsert(clone);
+    });
+}
+
+void Vfs::materializeAll() const {
+    while (!lazyDirs_.empty()) {
+        auto w = lazyDirs_.back();
+        lazyDirs_.pop_back();
+        if (auto dir = w.lock()) materialize(dir);
     }
 }
 
-void Vfs::indexInsert(const std::shared_ptr<FSNode>& n) {
+void Vfs::releasePins(const NodePtr& dir) const {
+    if (!dir || dir->lazyClones.empty()) return;
+    auto clones = std::move(dir->lazyClones);
+    dir->lazyClones.clear();
+    for (const auto& w : clones) {
+        if (auto clone = w.lock()) materialize(clone);
+    }
+}
+
+void Vfs::unpinForWrite(const NodePtr& node) const {
+    // Перед изменением узла все ленивые копии его предков должны забрать
+    // текущее (ещё не изменённое) состояние; идём от корня вниз.
+    std::vector<NodePtr> chain;
+    for (auto cur = node; cur; cur = cur->parent.lock()) chain.push_back(cur);
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        materialize(*it);
+        releasePins(*it);
+    }
+}
+
+void Vfs::indexInsert(const std::shared_ptr<FSNode>& n) const {
     if (!n) return;
     auto bucketOpt = nameIndex_.find(n->name);
     if (bucketOpt) {
@@ -454,7 +742,8 @@ std::string Vfs::readFile(const std::string& path) const {
         if (alt && !alt->isFile) throw VfsException(ErrorCode::InvalidArg);
         throw VfsException(ErrorCode::PathError);
     }
-    return f->content.asText();
+    if (!isCompressed(f->content)) return f->content.asText();
+    return *decompressedText(f);
 }
 
 void Vfs::writeFile(const std::string& path, const std::string& content, bool append) {
@@ -464,24 +753,265 @@ void Vfs::writeFile(const std::string& path, const std::string& content, bool ap
         if (alt && !alt->isFile) throw VfsException(ErrorCode::InvalidArg);
         throw VfsException(ErrorCode::PathError);
     }
-    if (append) f->content.append(std::vector<uint8_t>(content.begin(), content.end()));
-    else        f->content.assignText(content);
+    unpinForWrite(f);
+    const std::span<const std::uint8_t> data(reinterpret_cast<const std::uint8_t*>(content.data()), content.size());
+    if (!append) {
+        f->content.assignText(content);
+        recountFileStats(f);
+        compressOnWrite(f, false);
+    } else if (!appendCompressedFile(f, data)) {
+        expandForWrite(f);
+        f->content.append(data);
+        accountAppend(f, data.data(), data.size());
+        compressOnWrite(f, true);
+    }
     touchNode(f);
 }
 
-void Vfs::compress(const std::string& path, CompAlgo algo) {
-    auto f = resolve(path);
-    if (!f) throw VfsException(ErrorCode::PathError);
-    if (!f->isFile) throw VfsException(ErrorCode::InvalidArg);
-    compressInplace(f->content, algo);
+void Vfs::importHostFile(const std::string& hostPath, const std::string& path) {
+    if (hostPath.empty() || path.empty()) throw VfsException(ErrorCode::InvalidArg);
+    auto host = HostFile::open(hostPath);
+    auto f = resolve(path, ResolveKind::File);
+    if (!f) {
+        auto alt = resolve(path, ResolveKind::Any);
+        if (alt && !alt->isFile) throw VfsException(ErrorCode::InvalidArg);
+        createFile(path);
+        f = resolve(path, ResolveKind::File);
+    }
+    unpinForWrite(f);
+    f->content.mapHostFile(std::move(host));
+    recountFileStats(f);
+    compressOnWrite(f, false);
+    touchNode(f);
 }
 
-void Vfs::decompress(const std::string& path) {
+void Vfs::compress(const std::string& path, CompAlgo algo, unsigned threads, const AutoObjective& objective,
+                   std::uint32_t dictId) {
     auto node = resolve(path);
     if (!node) throw VfsException(ErrorCode::PathError);
-    decompressNode(node);
+    const DictionaryPtr dict = dictId ? loadDictionary(dictId) : nullptr;
+    if (algo == CompAlgo::LZ_DICT && !dict) throw VfsException(ErrorCode::InvalidArg);
+    unpinForWrite(node);
+    transformFiles(withoutDictionaries(collectFilesForWrite(node)), threads,
+                   [algo, &objective, &dict](FileContent& c, unsigned t) {
+        if (isCompressed(c)) return false;
+        FileContent packed = c;
+        compressInplace(packed, algo, t, objective, dict);
+        // как и при записи по политике: файл, который только вырос бы, не трогаем
+        if (packed.size() >= c.size()) return false;
+        c = std::move(packed);
+        return true;
+    });
+}
+
+void Vfs::decompress(const std::string& path, unsigned threads) {
+    auto node = resolve(path);
+    if (!node) throw VfsException(ErrorCode::PathError);
+    const DictionaryLookup dicts = dictionaryLookup();
+    unpinForWrite(node);
+    transformFiles(withoutDictionaries(collectFilesForWrite(node)), threads, [&dicts](FileContent& c, unsigned t) {
+        if (!isCompressed(c)) return false;
+        uncompressInplace(c, t, dicts);
+        return true;
+    });
+}
+
+std::vector<Vfs::NodePtr> Vfs::withoutDictionaries(std::vector<NodePtr> files) const {
+    auto dictDir = resolve(kDictDir, ResolveKind::Directory);
+    if (!dictDir) return files;
+    std::erase_if(files, [&](const NodePtr& f) { return f->parent.lock() == dictDir; });
+    return files;
+}
+
+std::uint32_t Vfs::trainDictionary(const std::string& dir, std::size_t maxBytes) {
+    auto node = resolve(dir);
+    if (!node) throw VfsException(ErrorCode::PathError);
+    if (maxBytes == 0 || maxBytes > kMaxDictionary) throw VfsException(ErrorCode::InvalidArg);
+    materializeAll();
+    // Образцы — несжатые файлы поддерева; страницы больших файлов читаются без копирования.
+    std::vector<std::vector<std::uint8_t>> copies;
+    std::vector<std::span<const std::uint8_t>> samples;
+    std::size_t total = 0;
+    std::vector<NodePtr> stack{node};
+    while (!stack.empty() && total < kMaxTrainingBytes) {
+        auto n = std::move(stack.back());
+        stack.pop_back();
+        if (!n->isFile) {
+            forEachChild(n, [&](const NodePtr& child){ stack.push_back(child); });
+            continue;
+        }
+        const FileContent& c = n->content;
+        if (c.size() == 0 || isCompressed(c)) continue;
+        const std::size_t take = std::min(c.size(), kMaxTrainingBytes - total);
+        auto span = c.view(0, take);
+        if (span.size() < take) {
+            copies.push_back(c.read(0, take));
+            span = copies.back();
+        }
+        samples.push_back(span);
+        total += take;
+    }
+    auto bytes = ::trainDictionary(samples, maxBytes);
+    if (bytes.empty()) throw VfsException(ErrorCode::InvalidArg);
+    auto dict = makeDictionary(std::move(bytes));
+
+    const std::string path = dictionaryPath(dict->id);
+    if (auto existing = resolve(path, ResolveKind::File)) {
+        // тот же id — почти наверняка тот же словарь; иначе коллизия хеша
+        if (existing->content.bytes() != dict->bytes) throw VfsException(ErrorCode::Conflict);
+        return dict->id;
+    }
+    if (!resolve(kDictDir, ResolveKind::Directory)) mkdir(kDictDir);
+    createFile(path);
+    auto f = resolveForWrite(path);
+    f->content.replaceAll(dict->bytes);
+    refreshNodeStats(f);
+    return dict->id;
+}
+
+DictionaryPtr Vfs::loadDictionary(std::uint32_t id) const {
+    auto dict = findDictionaryFile(id);
+    if (!dict) throw VfsException(ErrorCode::NotFound);
+    if (dict->id != id) throw VfsException(ErrorCode::Corrupted);
+    return dict;
+}
+
+DictionaryLookup Vfs::dictionaryLookup() const {
+    auto dicts = std::make_shared<std::unordered_map<std::uint32_t, DictionaryPtr>>();
+    if (auto dir = resolve(kDictDir, ResolveKind::Directory)) {
+        materialize(dir);
+        forEachChild(dir, [&](const NodePtr& f) {
+            if (!f->isFile || f->content.size() > kMaxDictionary) return;
+            auto dict = makeDictionary(f->content.bytes());
+            // файл, переименованный вручную, под чужим id не отдаём
+            if (f->name == dictionaryName(dict->id)) dicts->emplace(dict->id, dict);
+        });
+    }
+    return [dicts](std::uint32_t id) -> DictionaryPtr {
+        auto it = dicts->find(id);
+        return it == dicts->end() ? nullptr : it->second;
+    };
+}
+
+std::shared_ptr<FSNode> Vfs::resolveForWrite(const std::string& path) {
+    auto f = resolve(path, ResolveKind::File);
+    if (f) {
+        unpinForWrite(f);
+        // пишущий работает с байтами файла напрямую — отдаём их распакованными
+        expandForWrite(f);
+    }
+    return f;
 }
 
 void Vfs::refreshNodeStats(const NodePtr& node) {
+    recountFileStats(node);
+    compressOnWrite(node, false);
+    touchNode(node);
+}
+
+void Vfs::refreshNodeStatsAfterAppend(const NodePtr& node, const std::uint8_t* data, std::size_t n) {
+    accountAppend(node, data, n);
+    compressOnWrite(node, true);
     touchNode(node);
 }
+
+void Vfs::setCompressionPolicy(const std::string& dir, std::optional<CompressionPolicy> policy) {
+    auto node = resolve(dir, ResolveKind::Directory);
+    if (!node) {
+        if (resolve(dir, ResolveKind::File)) throw VfsException(ErrorCode::InvalidArg);
+        throw VfsException(ErrorCode::PathError);
+    }
+    if (policy && policy->enabled) {
+        if (policy->algo == CompAlgo::LZ_DICT && !policy->dictId) throw VfsException(ErrorCode::InvalidArg);
+        // словарь должен существовать уже сейчас, а не всплыть ошибкой при записи
+        if (policy->dictId) (void)loadDictionary(policy->dictId);
+    }
+    unpinForWrite(node);
+    node->compression = std::move(policy);
+    touchNode(node);
+}
+
+std::optional<CompressionPolicy> Vfs::compressionPolicy(const std::string& dir) const {
+    auto node = resolve(dir, ResolveKind::Directory);
+    if (!node) throw VfsException(ErrorCode::PathError);
+    return node->compression;
+}
+
+const CompressionPolicy* Vfs::effectivePolicy(const NodePtr& node) const {
+    for (auto cur = node; cur; cur = cur->parent.lock()) {
+        if (cur->isFile || !cur->compression) continue;
+        return cur->compression->enabled ? &*cur->compression : nullptr;
+    }
+    return nullptr;
+}
+
+DictionaryPtr Vfs::findDictionaryFile(std::uint32_t id) const {
+    auto f = resolve(dictionaryPath(id), ResolveKind::File);
+    if (!f) return nullptr;
+    auto& [node, dict] = dictionaries_[id];
+    if (node != f) {
+        node = f;
+        dict = makeDictionary(f->content.bytes());
+    }
+    return dict;
+}
+
+DecompressCache::Text Vfs::decompressedText(const NodePtr& f) const {
+    const std::size_t stored = f->content.size();
+    if (auto hit = cache_->find(f, stored)) return hit;
+    FileContent plain = f->content;     // копия разделяет страницы, байты не копируются
+    uncompressInplace(plain, 0, [this](std::uint32_t id) { return findDictionaryFile(id); });
+    auto text = std::make_shared<const std::string>(plain.asText());
+    cache_->insert(f, stored, text);
+    return text;
+}
+
+bool Vfs::inDictionaryDir(const NodePtr& f) const {
+    auto dir = f->parent.lock();
+    return dir && dir->name == kDictDir + 1 && dir->parent.lock() == root_;
+}
+
+bool Vfs::appendCompressedFile(const NodePtr& f, std::span<const std::uint8_t> data) {
+    if (!isCompressed(f->content) || !effectivePolicy(f)) return false;
+    if (!appendCompressed(f->content, data, 0, [this](std::uint32_t id) { return findDictionaryFile(id); }))
+        return false;
+    recountFileStats(f);
+    return true;
+}
+
+bool Vfs::expandForWrite(const NodePtr& f) {
+    if (!f || !isCompressed(f->content)) return false;
+    auto text = decompressedText(f);
+    f->content.replaceAll(std::span<const std::uint8_t>(reinterpret_cast<const std::uint8_t*>(text->data()),
+                                                         text->size()));
+    recountFileStats(f);
+    cache_->invalidate(f.get());
+    return true;
+}
+
+bool Vfs::compressOnWrite(const NodePtr& f, bool appended) {
+    const std::size_t size = f->content.size();
+    if (!appended) f->compressRetrySize = 0;
+    const CompressionPolicy* policy = effectivePolicy(f);
+    if (!policy || size == 0 || isCompressed(f->content)) return false;
+    if (inDictionaryDir(f) || size < f->compressRetrySize) return false;
+    // Запись уже состоялась, так что пропавший словарь её не отменяет: файл
+    // просто остаётся несжатым, как и несжимаемый.
+    DictionaryPtr dict;
+    if (policy->dictId) {
+        dict = findDictionaryFile(policy->dictId);
+        if (!dict || dict->id != policy->dictId) return false;
+    }
+    FileContent packed = f->content;
+    compressInplace(packed, policy->algo, 0, policy->objective, dict);
+    // Мелкий или несжимаемый файл с заголовком CMP только вырастет — остаётся как
+    // есть. Следующая попытка — когда файл удвоится (и вырастет хотя бы на блок):
+    // файл, собранный дозаписями, в сумме пересжимается за O(его размера).
+    if (packed.size() >= size) {
+        f->compressRetrySize = size + std::max(size, kCompressBlock);
+        return false;
+    }
+    f->content = std::move(packed);
+    recountFileStats(f);
+    return true;
+}
@@ -13,6 +13,7 @@
 #include <iomanip>
 #include <ctime>
 #include <algorithm>
+#include <charconv>
 
 static constexpr std::size_t kBufferedCliBufSize = 16;
 
@@ -26,9 +27,15 @@ static void printHelp() {
               << "rm <path>\n"
               << "rename <path> <newname>\n"
               << "mv <src> <dst_dir>\n"
-              << "cp <src> <dst>\n"
+              << "cp [--lazy] <src> <dst>\n"
               << "find <filename>\n"
               << "props <path>\n"
+              << "du [path]\n"
+              << "dedup on|off\n"
+              << "dedupstats\n"
+              << "charcount [bytes|utf8]\n"
+              << "mem [path]\n"
+              << "import <hostpath> <vpath>\n"
               << "tree\n"
               << "cat <path>\n"
             //   << "bcat <path>\n"
@@ -38,8 +45,11 @@ static void printHelp() {
             //   << "becho <text> > <path>\n"
             //   << "becho <text> >> <path>\n"
               << "read <path>\n"
-              << "compress <path> [all|alpha]\n"
-              << "decompress <path>\n"
+              << "compress [-r] <path> [all|alpha|fast|best|wide|stored|dict:<id>|auto[:size|:speed|:W]] [-j N]\n"
+              << "decompress [-r] <path> [-j N]\n"
+              << "train-dict <dir> [bytes]\n"
+              << "autocompress <dir> [off|inherit|all|alpha|fast|best|wide|stored|dict:<id>|auto[:size|:speed|:W]]\n"
+              << "cachestats\n"
             //  << "savejson <path>\n"
               << "help\n"
               << "exit\n";
@@ -47,7 +57,7 @@ static void printHelp() {
 
 enum class Cmd {
     Exit, Help, Pwd, Ls, Cd, Mkdir, Create, Rm, Rename, Mv, Cp,
-    Find, Props, Tree, Cat, BCat, Nano, Echo, BEcho, Read, Compress, Decompress, Savejson,
+    Find, Props, Du, Dedup, DedupStats, CharCount, Mem, Import, Tree, Cat, BCat, Nano, Echo, BEcho, Read, Compress, Decompress, TrainDict, AutoCompress, CacheStats, Savejson,
     Unknown
 };
 
@@ -65,6 +75,12 @@ static Cmd parseCmd(std::string_view s) {
     if (s=="cp")       return Cmd::Cp;
     if (s=="find")     return Cmd::Find;
     if (s=="props")    return Cmd::Props;
+    if (s=="du")       return Cmd::Du;
+    if (s=="dedup")    return Cmd::Dedup;
+    if (s=="dedupstats") return Cmd::DedupStats;
+    if (s=="charcount") return Cmd::CharCount;
+    if (s=="mem")      return Cmd::Mem;
+    if (s=="import")   return Cmd::Import;
     if (s=="tree")     return Cmd::Tree;
     if (s=="cat")      return Cmd::Cat;
     if (s=="bcat")     return Cmd::BCat;
@@ -74,6 +90,9 @@ static Cmd parseCmd(std::string_view s) {
     if (s=="read")     return Cmd::Read;
     if (s=="compress") return Cmd::Compress;
     if (s=="decompress") return Cmd::Decompress;
+    if (s=="train-dict") return Cmd::TrainDict;
+    if (s=="autocompress") return Cmd::AutoCompress;
+    if (s=="cachestats") return Cmd::CacheStats;
     if (s=="savejson") return Cmd::Savejson;
     return Cmd::Unknown;
 }
@@ -88,14 +107,69 @@ static void printUsage(std::string_view cmd, std::string_view u) {
     std::cout << "usage: " << cmd << " " << u << "\n";
 }
 
-static bool parseCompressionAlgo(const std::string& name, CompAlgo& algoOut) {
+// «auto» — выбор по пробному сжатию; после двоеточия цель: size, speed или вес скорости.
+static bool parseAutoObjective(const std::string& goal, AutoObjective& objective) {
+    if (goal.empty()) return true;
+    if (goal == "size")  { objective.speedWeight = 0.0; return true; }
+    if (goal == "speed") { objective.speedWeight = 10.0; return true; }
+    auto [end, ec] = std::from_chars(goal.data(), goal.data() + goal.size(), objective.speedWeight);
+    return ec == std::errc() && end == goal.data() + goal.size() && objective.speedWeight >= 0;
+}
+
+// «dict:<id>» — LZ_DICT с общим словарём из train-dict (id в hex).
+static bool parseCompressionAlgo(const std::string& name, CompAlgo& algoOut, AutoObjective& objective,
+                                 std::uint32_t& dictId) {
     std::string lower;
     lower.resize(name.size());
     std::transform(name.begin(), name.end(), lower.begin(), [](unsigned char ch){
         return static_cast<char>(std::tolower(ch));
     });
+    if (lower == "auto" || lower.starts_with("auto:")) {
+        algoOut = CompAlgo::AUTO;
+        return parseAutoObjective(lower.size() > 4 ? lower.substr(5) : std::string(), objective);
+    }
+    if (lower.starts_with("dict:")) {
+        algoOut = CompAlgo::LZ_DICT;
+        const char* first = lower.data() + 5;
+        const char* last = lower.data() + lower.size();
+        auto [end, ec] = std::from_chars(first, last, dictId, 16);
+        return ec == std::errc() && end == last && first != last && dictId != 0;
+    }
     if (lower == "all")  { algoOut = CompAlgo::LZW_VAR_ALL; return true; }
     if (lower == "alpha"){ algoOut = CompAlgo::LZW_VAR_ALPHA; return true; }
+    if (lower == "fast") { algoOut = CompAlgo::LZ_FAST; return true; }
+    if (lower == "best") { algoOut = CompAlgo::LZ_HUFF; return true; }
+    if (lower == "wide") { algoOut = CompAlgo::LZW_WIDE; return true; }
+    if (lower == "stored") { algoOut = CompAlgo::STORED; return true; }
+    return false;
+}
+
+// Забирает из аргументов «-j N» — число потоков сжатия; false, если N не число.
+static bool takeThreadsOption(std::vector<std::string>& a, unsigned& threads) {
+    auto it = std::find(a.begin(), a.end(), "-j");
+    if (it == a.end()) return true;
+    if (it + 1 == a.end()) return false;
+    const std::string& n = *(it + 1);
+    auto [end, ec] = std::from_chars(n.data(), n.data() + n.size(), threads);
+    if (ec != std::errc() || end != n.data() + n.size()) return false;
+    a.erase(it, it + 2);
+    return true;
+}
+
+// Забирает из аргументов флаг flag; true, если он был.
+static bool takeFlag(std::vector<std::string>& a, std::string_view flag) {
+    auto it = std::find(a.begin(), a.end(), flag);
+    if (it == a.end()) return false;
+    a.erase(it);
+    return true;
+}
+
+// Каталог сжимается только с -r, как rm/cp в оболочке; иначе — подсказка.
+static bool checkRecursive(Vfs& v, std::string_view cmd, const std::string& path, bool recursive) {
+    auto node = v.resolve(path);
+    if (!node) throw VfsException(ErrorCode::PathError);
+    if (node->isFile || recursive) return true;
+    std::cout << cmd << ": '" << path << "' is a directory (use -r)\n";
     return false;
 }
 
@@ -134,6 +208,18 @@ static void printNodeProps(const std::shared_ptr<FSNode>& node) {
               << "modified: " << formatTimestamp(node->fileProps.modifiedAt) << "\n"
               << "chars: " << node->fileProps.charCount << "\n"
               << "bytes: " << node->fileProps.byteSize << "\n";
+    if (node->isFile) {
+        std::cout << "logical bytes: " << node->content.size() << "\n"
+                  << "physical bytes: " << node->content.physicalBytes() << "\n"
+                  << "apparent size: " << node->content.size() << "\n"
+                  << "allocated size: " << node->content.allocatedBytes() << "\n"
+                  << "storage: " << (node->content.isInline() ? "inline"
+                                     : node->content.hostBacked() ? "host" : node->content.paged() ? "paged" : "buffer") << "\n"
+                  << "memory: " << Vfs::nodeMemory(*node) + node->content.heapBytes() << "\n";
+    } else {
+        std::cout << "files: " << node->fileProps.fileCount << "\n"
+                  << "dirs: " << node->fileProps.dirCount << "\n";
+    }
 }
 
 // === Стандартные команды ===
@@ -168,8 +254,10 @@ static void doMv(Vfs& v, const std::vector<std::string>& a){
     v.mv(a[0], a[1]);
 }
 static void doCp(Vfs& v, const std::vector<std::string>& a){
-    if (a.size() != 2) { printUsage("cp","<src> <dst>"); return; }
-    v.cp(a[0], a[1]);
+    bool lazy = !a.empty() && a[0] == "--lazy";
+    if (a.size() != (lazy ? 3u : 2u)) { printUsage("cp","[--lazy] <src> <dst>"); return; }
+    if (lazy) v.cp(a[1], a[2], Vfs::CopyMode::Lazy);
+    else      v.cp(a[0], a[1]);
 }
 static void doFind(Vfs& v, const std::vector<std::string>& a){
     if (a.size() != 1) { printUsage("find","<filename>"); return; }
@@ -192,6 +280,59 @@ static void doProps(Vfs& v, const std::vector<std::string>& a){
     if (!node) throw VfsException(ErrorCode::PathError);
     printNodeProps(node);
 }
+static void doDu(Vfs& v, const std::vector<std::string>& a){
+    if (a.size() > 1) { printUsage("du","[path]"); return; }
+    auto node = v.resolve(a.empty() ? "" : a[0]);
+    if (!node) throw VfsException(ErrorCode::PathError);
+    const auto& p = node->fileProps;
+    std::cout << p.byteSize << "\t" << fullPathOfNode(node);
+    if (!node->isFile) std::cout << " (files: " << p.fileCount << ", dirs: " << p.dirCount << ")";
+    std::cout << "\n";
+}
+static void doDedup(Vfs& v, const std::vector<std::string>& a){
+    if (a.size() != 1 || (a[0] != "on" && a[0] != "off")) { printUsage("dedup","on|off"); return; }
+    v.setDedup(a[0] == "on");
+}
+static void doCharCount(Vfs& v, const std::vector<std::string>& a){
+    if (a.empty()) { std::cout << "charcount: " << (v.countCodePoints() ? "utf8" : "bytes") << "\n"; return; }
+    if (a.size() != 1 || (a[0] != "bytes" && a[0] != "utf8")) { printUsage("charcount","[bytes|utf8]"); return; }
+    v.setCountCodePoints(a[0] == "utf8");
+}
+static void doDedupStats(Vfs& v, const std::vector<std::string>& a){
+    if (!a.empty()) { printUsage("dedupstats",""); return; }
+    auto st = v.dedupStats();
+    std::cout << "dedup: " << (v.dedupEnabled() ? "on" : "off") << "\n"
+              << "files: " << st.files << "\n"
+              << "blobs: " << st.blobs << "\n"
+              << "logical bytes: " << st.logicalBytes << "\n"
+              << "physical bytes: " << st.physicalBytes << "\n"
+              << "saved bytes: " << (st.logicalBytes - std::min(st.logicalBytes, st.physicalBytes)) << "\n";
+}
+static void doCacheStats(Vfs& v, const std::vector<std::string>& a){
+    if (!a.empty()) { printUsage("cachestats",""); return; }
+    auto st = v.cacheStats();
+    std::cout << "hits: " << st.hits << "\n"
+              << "misses: " << st.misses << "\n"
+              << "hit rate: " << std::fixed << std::setprecision(1) << st.hitRate() * 100 << "%\n"
+              << std::defaultfloat
+              << "entries: " << st.entries << "\n"
+              << "cached bytes: " << st.bytes << "\n"
+              << "capacity bytes: " << st.capacity << "\n"
+              << "evictions: " << st.evictions << "\n";
+}
+static void doMem(Vfs& v, const std::vector<std::string>& a){
+    if (a.size() > 1) { printUsage("mem","[path]"); return; }
+    auto st = v.memoryUsage(a.empty() ? "" : a[0]);
+    std::cout << "nodes: " << st.nodes << "\n"
+              << "inline files: " << st.inlineFiles << "\n"
+              << "node bytes: " << st.nodeBytes << "\n"
+              << "content bytes: " << st.contentBytes << "\n"
+              << "total bytes: " << st.total() << "\n";
+}
+static void doImport(Vfs& v, const std::vector<std::string>& a){
+    if (a.size() != 2) { printUsage("import","<hostpath> <vpath>"); return; }
+    v.importHostFile(a[0], a[1]);
+}
 static void doTree(Vfs& v, const std::vector<std::string>&){ v.printTree(); }
 
 // === Новые команды ===
@@ -205,7 +346,9 @@ static void doBCat(Vfs& v, const std::vector<std::string>& a){
     auto node = v.resolve(a[0], Vfs::ResolveKind::File);
     if (!node) throw VfsException(ErrorCode::PathError);
 
-    OIStream stream(node->content, StreamMode::ReadOnly, kBufferedCliBufSize);
+    // сжатый файл показываем распакованным, не распаковывая его целиком
+    auto mode = isCompressed(node->content) ? StreamMode::ReadDecompressed : StreamMode::ReadOnly;
+    OIStream stream(node->content, mode, kBufferedCliBufSize, v.dictionaryLookup());
     stream.Open();
     std::vector<std::uint8_t> chunk(kBufferedCliBufSize);
     while (true) {
@@ -255,15 +398,19 @@ static void doBEcho(Vfs& v, const std::vector<std::string>& a){
         content += a[i];
     }
     bool append = (a[a.size()-2] == ">>");
-    auto node = v.resolve(a.back(), Vfs::ResolveKind::File);
+    if (append) {
+        // writeFile сам ищет файл и дописывает в сжатый, не распаковывая его целиком
+        v.writeFile(a.back(), content + '\n', true);
+        return;
+    }
+    auto node = v.resolveForWrite(a.back());
     if (!node) throw VfsException(ErrorCode::PathError);
-    if (!append) node->content.truncate(0);
+    node->content.truncate(0);
 
     OIStream stream(node->content, StreamMode::WriteOnly, kBufferedCliBufSize);
     stream.Open();
-    if (append) stream.Seek(node->content.size());
+    content.push_back('\n');
     stream.WriteString(content);
-    stream.WriteChar('\n');
     stream.Close();
     v.refreshNodeStats(node);
 }
@@ -275,22 +422,102 @@ static void doRead(Vfs& v, const std::vector<std::string>& a){
     while (std::getline(iss, line)) std::cout << line << "\n";
 }
 
-static void doCompress(Vfs& v, const std::vector<std::string>& a){
-    if (a.empty() || a.size() > 2) { printUsage("compress", "<path> [all|alpha]"); return; }
+static void doCompress(Vfs& v, const std::vector<std::string>& args){
+    std::vector<std::string> a = args;
+    unsigned threads = 0;
+    const bool recursive = takeFlag(a, "-r");
+    if (!takeThreadsOption(a, threads) || a.empty() || a.size() > 2) {
+        printUsage("compress", "[-r] <path> [all|alpha|fast|best|wide|stored|dict:<id>|auto[:size|:speed|:W]] [-j N]");
+        return;
+    }
     CompAlgo algo = CompAlgo::LZW_VAR_ALL;
+    AutoObjective objective;
+    std::uint32_t dictId = 0;
     if (a.size() == 2) {
-        if (!parseCompressionAlgo(a[1], algo)) {
+        if (!parseCompressionAlgo(a[1], algo, objective, dictId)) {
             std::cout << "unknown compression algorithm '" << a[1]
-                      << "', expected 'all' or 'alpha'\n";
+                      << "', expected 'all', 'alpha', 'fast', 'best', 'wide', 'stored', 'dict:<id>' or 'auto'\n";
             return;
         }
     }
-    v.compress(a[0], algo);
+    if (!checkRecursive(v, "compress", a[0], recursive)) return;
+    v.compress(a[0], algo, threads, objective, dictId);
+}
+
+static void doDecompress(Vfs& v, const std::vector<std::string>& args){
+    std::vector<std::string> a = args;
+    unsigned threads = 0;
+    const bool recursive = takeFlag(a, "-r");
+    if (!takeThreadsOption(a, threads) || a.size() != 1) {
+        printUsage("decompress", "[-r] <path> [-j N]");
+        return;
+    }
+    if (!checkRecursive(v, "decompress", a[0], recursive)) return;
+    v.decompress(a[0], threads);
+}
+
+static void doTrainDict(Vfs& v, const std::vector<std::string>& a){
+    std::size_t maxBytes = kMaxDictionary;
+    bool ok = a.size() == 1 || a.size() == 2;
+    if (ok && a.size() == 2) {
+        auto [end, ec] = std::from_chars(a[1].data(), a[1].data() + a[1].size(), maxBytes);
+        ok = ec == std::errc() && end == a[1].data() + a[1].size();
+    }
+    if (!ok) { printUsage("train-dict", "<dir> [bytes]"); return; }
+    const std::uint32_t id = v.trainDictionary(a[0], maxBytes);
+    auto dict = v.loadDictionary(id);
+    std::ostringstream name;
+    name << std::hex << std::setw(8) << std::setfill('0') << id;
+    std::cout << "dictionary " << name.str() << " (" << dict->bytes.size() << " bytes)\n"
+              << "use: compress -r " << a[0] << " dict:" << name.str() << "\n";
+}
+
+static std::string describePolicy(const CompressionPolicy& p) {
+    if (!p.enabled) return "off";
+    switch (p.algo) {
+        case CompAlgo::LZW_VAR_ALL:   return "all";
+        case CompAlgo::LZW_VAR_ALPHA: return "alpha";
+        case CompAlgo::LZ_FAST:       return "fast";
+        case CompAlgo::LZ_HUFF:       return "best";
+        case CompAlgo::LZW_WIDE:      return "wide";
+        case CompAlgo::STORED:        return "stored";
+        case CompAlgo::LZ_DICT: {
+            std::ostringstream oss;
+            oss << "dict:" << std::hex << std::setw(8) << std::setfill('0') << p.dictId;
+            return oss.str();
+        }
+        case CompAlgo::AUTO: {
+            std::ostringstream oss;
+            oss << "auto:" << p.objective.speedWeight;
+            return oss.str();
+        }
+    }
+    return "?";
 }
 
-static void doDecompress(Vfs& v, const std::vector<std::string>& a){
-    if (a.size() != 1) { printUsage("decompress", "<path>"); return; }
-    v.decompress(a[0]);
+// Без режима — показывает политику каталога; inherit снимает собственную.
+static void doAutoCompress(Vfs& v, const std::vector<std::string>& a){
+    if (a.empty() || a.size() > 2) {
+        printUsage("autocompress", "<dir> [off|inherit|all|alpha|fast|best|wide|stored|dict:<id>|auto[:size|:speed|:W]]");
+        return;
+    }
+    if (a.size() == 1) {
+        auto own = v.compressionPolicy(a[0]);
+        const CompressionPolicy* effective = v.effectivePolicy(v.resolve(a[0], Vfs::ResolveKind::Directory));
+        std::cout << "policy: " << (own ? describePolicy(*own) : "inherit")
+                  << " (effective: " << (effective ? describePolicy(*effective) : "off") << ")\n";
+        return;
+    }
+    if (a[1] == "inherit") { v.setCompressionPolicy(a[0], std::nullopt); return; }
+    CompressionPolicy policy;
+    if (a[1] != "off") {
+        policy.enabled = true;
+        if (!parseCompressionAlgo(a[1], policy.algo, policy.objective, policy.dictId)) {
+            std::cout << "unknown compression algorithm '" << a[1] << "'\n";
+            return;
+        }
+    }
+    v.setCompressionPolicy(a[0], policy);
 }
 
 static void doSaveJson(Vfs& v, const std::vector<std::string>& a){
@@ -326,6 +553,12 @@ void runVfsCLI() {
                 case Cmd::Cp:         doCp(vfs, args);         break;
                 case Cmd::Find:       doFind(vfs, args);       break;
                 case Cmd::Props:      doProps(vfs, args);      break;
+                case Cmd::Du:         doDu(vfs, args);         break;
+                case Cmd::Dedup:      doDedup(vfs, args);      break;
+                case Cmd::CharCount:  doCharCount(vfs, args);  break;
+                case Cmd::DedupStats: doDedupStats(vfs, args); break;
+                case Cmd::Mem:        doMem(vfs, args);        break;
+                case Cmd::Import:     doImport(vfs, args);     break;
                 case Cmd::Tree:       doTree(vfs, args);       break;
                 case Cmd::Cat:        doCat(vfs, args);        break;
                 case Cmd::BCat:       doBCat(vfs, args);       break;
@@ -335,6 +568,9 @@ void runVfsCLI() {
                 case Cmd::Read:       doRead(vfs, args);       break;
                 case Cmd::Compress:   doCompress(vfs, args);   break;
                 case Cmd::Decompress: doDecompress(vfs, args); break;
+                case Cmd::TrainDict:  doTrainDict(vfs, args);  break;
+                case Cmd::AutoCompress: doAutoCompress(vfs, args); break;
+                case Cmd::CacheStats: doCacheStats(vfs, args); break;
                 case Cmd::Savejson:   doSaveJson(vfs, args);   break;
                 case Cmd::Unknown:
                 default: std::cout << "unknown command (type 'help')\n"; break;
@@ -1,6 +1,10 @@
 #include "Compression.hpp"
+#include "Crc32c.hpp"
 #include "Errors.hpp"
 #include "FileContent.hpp"
+#include "Lzw.hpp"
+#include "LzFast.hpp"
+#include "LzHuff.hpp"
 #include "TestUtils.hpp"
 
 #include <algorithm>
@@ -15,7 +19,15 @@
 namespace {
 
 using ByteVec = std::vector<std::uint8_t>;
-constexpr std::array<CompAlgo, 2> kAllAlgorithms{
+constexpr std::array<CompAlgo, 6> kAllAlgorithms{
+    CompAlgo::LZW_VAR_ALL,
+    CompAlgo::LZW_VAR_ALPHA,
+    CompAlgo::LZ_FAST,
+    CompAlgo::LZ_HUFF,
+    CompAlgo::LZW_WIDE,
+    CompAlgo::STORED
+};
+constexpr std::array<CompAlgo, 2> kLzwAlgorithms{
     CompAlgo::LZW_VAR_ALL,
     CompAlgo::LZW_VAR_ALPHA
 };
@@ -24,6 +36,10 @@ const char* algoName(CompAlgo algo) {
     switch (algo) {
         case CompAlgo::LZW_VAR_ALL: return "LZW_VAR_ALL";
         case CompAlgo::LZW_VAR_ALPHA: return "LZW_VAR_ALPHA";
+        case CompAlgo::LZ_FAST: return "LZ_FAST";
+        case CompAlgo::LZ_HUFF: return "LZ_HUFF";
+        case CompAlgo::LZW_WIDE: return "LZW_WIDE";
+        case CompAlgo::STORED: return "STORED";
         default: return "UNKNOWN";
     }
 }
@@ -33,6 +49,12 @@ void forEachAlgo(Fn&& fn) {
     for (auto algo : kAllAlgorithms) fn(algo);
 }
 
+// Для проверок, завязанных на битовый поток LZW.
+template <typename Fn>
+void forEachLzw(Fn&& fn) {
+    for (auto algo : kLzwAlgorithms) fn(algo);
+}
+
 ByteVec toBytes(const std::string& s) {
     return ByteVec(s.begin(), s.end());
 }
@@ -153,6 +175,513 @@ void test_functional_roundtrip_multiple() {
         assertRoundtrip(s);
 }
 
+ByteVec sampleText(std::size_t n) {
+    const std::string words = "alpha beta gamma delta epsilon zeta eta theta ";
+    ByteVec out;
+    out.reserve(n);
+    for (std::size_t i = 0; out.size() < n; ++i) out.push_back(static_cast<std::uint8_t>(words[(i * 7) % words.size()]));
+    return out;
+}
+
+void test_streaming_matches_whole_input() {
+    const ByteVec data = sampleText(20000);
+    forEachLzw([&](CompAlgo algo){
+        FileContent f;
+        f.replaceAll(data);
+        compressInplace(f, algo);
+        // один блок: заголовок v5 и одна запись таблицы
+        assert(data.size() <= kCompressBlock);
+        ByteVec whole = f.read(33, f.size() - 33);
+
+        // тот же вход кусками разной длины даёт тот же поток
+        lzw::Encoder enc(algo == CompAlgo::LZW_VAR_ALPHA);
+        ByteVec chunked;
+        for (std::size_t pos = 0, step = 1; pos < data.size(); pos += step, step = step * 3 % 1000 + 1) {
+            std::size_t n = std::min(step, data.size() - pos);
+            enc.feed(std::span<const std::uint8_t>(data.data() + pos, n), chunked);
+        }
+        enc.finish(chunked);
+        assert(chunked == whole);
+
+        lzw::Decoder dec(algo == CompAlgo::LZW_VAR_ALPHA);
+        ByteVec decoded;
+        for (std::uint8_t b : chunked) dec.feed(std::span<const std::uint8_t>(&b, 1), decoded);
+        dec.finish();
+        assert(decoded == data);
+    });
+}
+
+void test_decompress_reader_small_reads() {
+    const ByteVec data = sampleText(3 * FileContent::kPageSize + 17);
+    forEachAlgo([&](CompAlgo algo){
+        FileContent f;
+        f.replaceAll(data);
+        compressInplace(f, algo);
+        DecompressReader reader(f);
+        assert(reader.size() == data.size());
+        ByteVec out;
+        std::array<std::uint8_t, 7> buf{};
+        while (std::size_t n = reader.read(buf)) out.insert(out.end(), buf.begin(), buf.begin() + static_cast<long>(n));
+        assert(out == data);
+        assert(reader.read(buf) == 0);
+    });
+}
+
+void test_reader_history_window() {
+    // Больше окна истории читателя: фразы копируются из окна, пока оно их держит,
+    // а старые — собираются по цепочке префиксов.
+    ByteVec data = sampleText(5 * 1024 * 1024);
+    std::mt19937 rng(7);
+    for (std::size_t i = 0; i < data.size(); i += 997) data[i] = static_cast<std::uint8_t>(rng());
+    forEachAlgo([&](CompAlgo algo){
+        FileContent f;
+        f.replaceAll(data);
+        compressInplace(f, algo);
+        DecompressReader reader(f);
+        ByteVec buf(4096), out;
+        out.reserve(data.size());
+        while (std::size_t n = reader.read(buf)) out.insert(out.end(), buf.begin(), buf.begin() + static_cast<long>(n));
+        assert(out == data);
+    });
+}
+
+// Эталонный поток LZW для строки ниже: изменения кодера не должны его менять.
+const std::string kGoldenText = "TOBEORNOTTOBEORTOBEORNOT#Hello, hello, HELLO!";
+const ByteVec kGoldenCommon = {
+    0x54, 0x9E, 0x08, 0x29, 0xF2, 0x44, 0x8A, 0x93, 0x27, 0x54, 0x00, 0x0A, 0x24, 0x98,
+    0x70, 0x60, 0xC1, 0x83, 0x23, 0x90, 0x94, 0x61, 0xC3, 0xE6, 0x0D, 0x0B, 0x10, 0x68};
+const ByteVec kGoldenAllTail = {0x24, 0x52, 0xB4, 0x88, 0xA4, 0x08, 0x13, 0x26, 0x4F, 0x42, 0x00};
+const ByteVec kGoldenAlphaTail = {0x20, 0x4A, 0x64, 0x01, 0x02, 0x49, 0x11, 0x26, 0x4C, 0x9E, 0x84, 0x00};
+
+ByteVec goldenPayload(CompAlgo algo) {
+    ByteVec out = kGoldenCommon;
+    const ByteVec& tail = algo == CompAlgo::LZW_VAR_ALL ? kGoldenAllTail : kGoldenAlphaTail;
+    out.insert(out.end(), tail.begin(), tail.end());
+    return out;
+}
+
+void test_format_is_stable() {
+    forEachLzw([&](CompAlgo algo){
+        FileContent f;
+        f.assignText(kGoldenText);
+        compressInplace(f, algo);
+        const ByteVec payload = goldenPayload(algo);
+        // v5: размер 45, блок 256 КиБ, один блок, конец блока и его CRC32C, затем поток
+        ByteVec expected = {
+            0x43, 0x4D, 0x50, 0x05, static_cast<std::uint8_t>(algo),
+            0x2D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x04, 0x00,
+            0x01, 0x00, 0x00, 0x00,
+            static_cast<std::uint8_t>(33 + payload.size()), 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0xD5, 0x5D, 0x08, 0xBB};
+        expected.insert(expected.end(), payload.begin(), payload.end());
+        assert(f.bytes() == expected);
+    });
+}
+
+void test_reads_legacy_v4() {
+    forEachLzw([&](CompAlgo algo){
+        const ByteVec payload = goldenPayload(algo);
+        ByteVec raw = {
+            0x43, 0x4D, 0x50, 0x04, static_cast<std::uint8_t>(algo),
+            0x2D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x04, 0x00,
+            0x01, 0x00, 0x00, 0x00,
+            static_cast<std::uint8_t>(29 + payload.size()), 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+        raw.insert(raw.end(), payload.begin(), payload.end());
+        FileContent f;
+        f.replaceAll(raw);
+        assert(isCompressed(f));
+        ByteVec part(6);
+        assert(readDecompressed(f, 25, part) == 6);
+        assert(std::string(part.begin(), part.end()) == "Hello,");
+        uncompressInplace(f);
+        assert(f.asText() == kGoldenText);
+    });
+}
+
+void test_crc32c_vectors() {
+    const std::string check = "123456789";
+    const ByteVec checkBytes(check.begin(), check.end());
+    assert(crc32c::compute(checkBytes) == 0xE3069283u);
+    assert(crc32c::extendSoftware(0, checkBytes) == 0xE3069283u);
+    assert(crc32c::compute({}) == 0);
+
+    // аппаратный путь совпадает с табличным на любых длинах и выравниваниях,
+    // а сумма по частям — с суммой целиком
+    ByteVec data(4096 + 64);
+    std::mt19937 rng(5);
+    for (auto& b : data) b = static_cast<std::uint8_t>(rng());
+    for (std::size_t off = 0; off < 9; ++off) {
+        for (std::size_t len : {0u, 1u, 7u, 8u, 9u, 63u, 1000u, 4096u}) {
+            std::span<const std::uint8_t> s(data.data() + off, len);
+            const std::uint32_t whole = crc32c::compute(s);
+            assert(whole == crc32c::extendSoftware(0, s));
+            const std::size_t cut = len / 3;
+            assert(crc32c::extend(crc32c::compute(s.first(cut)), s.subspan(cut)) == whole);
+        }
+    }
+}
+
+void test_checksum_catches_stored_damage() {
+    // байт внутри несжатого блока кодек не проверит — только контрольная сумма
+    ByteVec mixed = sampleText(kCompressBlock);
+    ByteVec noise(100000);
+    std::mt19937 rng(3);
+    for (auto& b : noise) b = static_cast<std::uint8_t>(rng());
+    mixed.insert(mixed.end(), noise.begin(), noise.end());
+    FileContent f;
+    f.replaceAll(mixed);
+    compressInplace(f, CompAlgo::LZ_FAST);
+    auto bytes = f.bytes();
+    assert(bytes[21 + 12 + 7] & 0x80);
+    bytes[bytes.size() - 500] ^= 0x01;
+    FileContent broken;
+    broken.replaceAll(bytes);
+    expectThrows(ErrorCode::Corrupted, [&]{
+        FileContent copy;
+        copy.replaceAll(bytes);
+        uncompressInplace(copy);
+    });
+    ByteVec window(1000);
+    expectThrows(ErrorCode::Corrupted, [&]{ readDecompressed(broken, mixed.size() - 1000, window); });
+    // первый блок цел и читается
+    assert(readDecompressed(broken, 0, window) == window.size());
+
+    // и в сжатом блоке: повреждённая сумма тоже не даёт отдать данные
+    forEachAlgo([&](CompAlgo algo){
+        FileContent g;
+        g.replaceAll(sampleText(5000));
+        compressInplace(g, algo);
+        auto b = g.bytes();
+        b[21 + 8] ^= 0x01;
+        FileContent bad;
+        bad.replaceAll(b);
+        DecompressReader reader(bad);
+        ByteVec buf(16);
+        expectThrows(ErrorCode::Corrupted, [&]{ reader.read(buf); });
+    });
+}
+
+void test_append_rewrites_only_tail() {
+    const ByteVec data = sampleText(2 * kCompressBlock + 70000);
+    for (CompAlgo algo : {CompAlgo::LZW_VAR_ALL, CompAlgo::LZ_FAST, CompAlgo::LZ_HUFF, CompAlgo::STORED}) {
+        FileContent f;
+        compressInplace(f, algo);
+        // куски разной длины, в том числе через границы блоков и крупнее блока
+        std::size_t pos = 0;
+        for (std::size_t step = 1; pos < data.size(); step = step * 7 % 300001 + 1) {
+            const std::size_t n = std::min(step, data.size() - pos);
+            assert(appendCompressed(f, std::span<const std::uint8_t>(data.data() + pos, n)));
+            pos += n;
+        }
+        // блоки независимы, поэтому результат тот же, что у сжатия целиком
+        FileContent whole;
+        whole.replaceAll(data);
+        compressInplace(whole, algo);
+        assert(f.bytes() == whole.bytes());
+        uncompressInplace(f);
+        assert(f.bytes() == data);
+    }
+
+    // v4 без контрольных сумм так не дописывается
+    forEachLzw([&](CompAlgo algo){
+        const ByteVec payload = goldenPayload(algo);
+        ByteVec raw = {
+            0x43, 0x4D, 0x50, 0x04, static_cast<std::uint8_t>(algo),
+            0x2D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x04, 0x00,
+            0x01, 0x00, 0x00, 0x00,
+            static_cast<std::uint8_t>(29 + payload.size()), 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+        raw.insert(raw.end(), payload.begin(), payload.end());
+        FileContent f;
+        f.replaceAll(raw);
+        const ByteVec more = toBytes("more");
+        assert(!appendCompressed(f, more));
+        assert(f.bytes() == raw);
+    });
+}
+
+void test_reads_legacy_v3() {
+    forEachLzw([&](CompAlgo algo){
+        ByteVec raw = {0x43, 0x4D, 0x50, 0x03, static_cast<std::uint8_t>(algo),
+                       0x2D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+        const ByteVec payload = goldenPayload(algo);
+        raw.insert(raw.end(), payload.begin(), payload.end());
+        FileContent f;
+        f.replaceAll(raw);
+        assert(isCompressed(f));
+
+        // в v3 назад можно только с начала, но результат тот же
+        ByteVec part(6);
+        assert(readDecompressed(f, 25, part) == 6);
+        assert(std::string(part.begin(), part.end()) == "Hello,");
+
+        uncompressInplace(f);
+        assert(f.asText() == kGoldenText);
+    });
+}
+
+void test_random_access_by_block() {
+    const ByteVec data = sampleText(3 * kCompressBlock + 1234);
+    forEachAlgo([&](CompAlgo algo){
+        FileContent f;
+        f.replaceAll(data);
+        compressInplace(f, algo);
+
+        // куски, пересекающие границы блоков, у начала, в середине и у конца
+        const std::size_t offsets[] = {0, kCompressBlock - 3, 2 * kCompressBlock + 77, data.size() - 10};
+        for (std::size_t off : offsets) {
+            ByteVec buf(100);
+            std::size_t n = readDecompressed(f, off, buf);
+            assert(n == std::min<std::size_t>(100, data.size() - off));
+            assert(std::equal(buf.begin(), buf.begin() + static_cast<long>(n), data.begin() + static_cast<long>(off)));
+        }
+        ByteVec buf(10);
+        assert(readDecompressed(f, data.size() + 5, buf) == 0);
+
+        // назад и вперёд в одном читателе
+        DecompressReader reader(f);
+        reader.seek(2 * kCompressBlock + 5);
+        assert(reader.tell() == 2 * kCompressBlock + 5);
+        assert(reader.read(buf) == 10);
+        assert(std::equal(buf.begin(), buf.end(), data.begin() + 2 * kCompressBlock + 5));
+        reader.seek(3);
+        assert(reader.read(buf) == 10);
+        assert(std::equal(buf.begin(), buf.end(), data.begin() + 3));
+    });
+}
+
+void test_threads_do_not_change_output() {
+    const ByteVec data = sampleText(5 * kCompressBlock + 99);
+    forEachAlgo([&](CompAlgo algo){
+        FileContent serial;
+        serial.replaceAll(data);
+        compressInplace(serial, algo, 1);
+        for (unsigned threads : {2u, 3u, 8u}) {
+            FileContent f;
+            f.replaceAll(data);
+            compressInplace(f, algo, threads);
+            assert(f.bytes() == serial.bytes());
+            uncompressInplace(f, threads);
+            assert(f.bytes() == data);
+        }
+    });
+}
+
+void test_fast_binary_and_overlaps() {
+    // Повторы с короткими смещениями (перекрывающиеся копии), длинные совпадения
+    // и литералы длиннее 15 — все ветки формата токена.
+    ByteVec data;
+    std::mt19937 rng(5);
+    for (int rep = 0; rep < 40; ++rep) {
+        for (int i = 0; i < 300; ++i) data.push_back(static_cast<std::uint8_t>(rng()));
+        data.insert(data.end(), 1000 + rep, static_cast<std::uint8_t>(rep));
+        for (int i = 0; i < 3; ++i) data.push_back(static_cast<std::uint8_t>(i));
+        const std::size_t from = data.size() - 700;
+        for (std::size_t i = 0; i < 600; ++i) data.push_back(data[from + i]);
+    }
+    assertRoundtripAlgo(data, CompAlgo::LZ_FAST);
+
+    FileContent f;
+    f.replaceAll(data);
+    compressInplace(f, CompAlgo::LZ_FAST);
+    assert(f.size() < data.size() / 2);
+}
+
+void test_fast_rejects_bad_offsets() {
+    ByteVec out;
+    // литерал 'a', затем совпадение со смещением 2 при одном байте вывода
+    const ByteVec badOffset = {0x10, 'a', 0x02, 0x00};
+    expectThrows(ErrorCode::Corrupted, [&]{ lzfast::decompress(badOffset, 5, out); });
+    // вывод короче заявленного
+    const ByteVec shortOut = {0x20, 'a', 'b'};
+    expectThrows(ErrorCode::Corrupted, [&]{ lzfast::decompress(shortOut, 3, out); });
+    // корректный поток: 'ab' и совпадение длины 4 со смещением 2 -> "ababab"
+    const ByteVec ok = {0x20, 'a', 'b', 0x02, 0x00, 0x00};
+    out.clear();
+    lzfast::decompress(ok, 6, out);
+    assert(std::string(out.begin(), out.end()) == "ababab");
+}
+
+void test_huff_ratio_and_skewed_alphabet() {
+    // на тексте энтропийная стадия обгоняет LZW
+    const ByteVec text = sampleText(kCompressBlock);
+    FileContent lzwFile, huffFile;
+    lzwFile.replaceAll(text);
+    huffFile.replaceAll(text);
+    compressInplace(lzwFile, CompAlgo::LZW_VAR_ALL);
+    compressInplace(huffFile, CompAlgo::LZ_HUFF);
+    assert(huffFile.size() < lzwFile.size());
+
+    // частоты по Фибоначчи дают дерево глубже kMaxCodeLen — проверка ограничения длины
+    ByteVec skewed;
+    std::uint32_t a = 1, b = 1;
+    for (std::uint8_t sym = 0; sym < 22; ++sym) {
+        skewed.insert(skewed.end(), a, sym);
+        std::uint32_t next = a + b;
+        a = b;
+        b = next;
+    }
+    std::mt19937 rng(11);
+    std::shuffle(skewed.begin(), skewed.end(), rng);
+    assertRoundtripAlgo(skewed, CompAlgo::LZ_HUFF);
+}
+
+void test_huff_rejects_damage() {
+    ByteVec out;
+    expectThrows(ErrorCode::Corrupted, [&]{ lzhuff::decompress(ByteVec(10, 0), 1, out); });
+
+    const ByteVec data = sampleText(20000);
+    ByteVec packed;
+    lzhuff::Compressor c;
+    c.compress(data, packed);
+    out.clear();
+    lzhuff::decompress(packed, data.size(), out);
+    assert(out == data);
+    // обрезанный поток и неверная длина
+    ByteVec cut(packed.begin(), packed.end() - 4);
+    expectThrows(ErrorCode::Corrupted, [&]{ out.clear(); lzhuff::decompress(cut, data.size(), out); });
+    expectThrows(ErrorCode::Corrupted, [&]{ out.clear(); lzhuff::decompress(packed, data.size() + 1, out); });
+    // порча заголовка длин и потока: либо Corrupted, либо другой вывод, но без выхода за буфер
+    std::mt19937 rng(3);
+    for (int i = 0; i < 200; ++i) {
+        ByteVec bad = packed;
+        bad[rng() % bad.size()] ^= static_cast<std::uint8_t>(1u << (rng() % 8));
+        try {
+            out.clear();
+            lzhuff::decompress(bad, data.size(), out);
+            assert(out.size() == data.size());
+        } catch (const VfsException& e) {
+            assert(e.code == ErrorCode::Corrupted);
+        }
+    }
+}
+
+void test_wide_clear_resets_stale_dictionary() {
+    // Два участка с непересекающимися алфавитами: 12-битный словарь заполняется
+    // на первом и без сброса плохо подходит ко второму.
+    ByteVec data;
+    std::mt19937 rng(8);
+    for (const char* alphabet : {"abcdefghijklm", "NOPQRSTUVWXYZ"}) {
+        std::vector<std::string> words;
+        for (int w = 0; w < 200; ++w) {
+            std::string word;
+            for (std::size_t len = 3 + rng() % 6; word.size() < len; ) word.push_back(alphabet[rng() % 13]);
+            words.push_back(word);
+        }
+        for (std::size_t n = 0; n < 300000; ) {
+            const auto& word = words[rng() % words.size()];
+            data.insert(data.end(), word.begin(), word.end());
+            data.push_back(' ');
+            n += word.size() + 1;
+        }
+    }
+    auto packedSize = [&](bool clearCode) {
+        const lzw::Params params{false, clearCode, 12};
+        lzw::Encoder enc(params);
+        ByteVec packed;
+        for (std::size_t pos = 0; pos < data.size(); pos += 10000) {
+            enc.feed(std::span<const std::uint8_t>(data.data() + pos, std::min<std::size_t>(10000, data.size() - pos)), packed);
+        }
+        enc.finish(packed);
+        lzw::Decoder dec(params);
+        ByteVec decoded;
+        for (std::size_t pos = 0; pos < packed.size(); pos += 777) {
+            dec.feed(std::span<const std::uint8_t>(packed.data() + pos, std::min<std::size_t>(777, packed.size() - pos)), decoded);
+        }
+        dec.finish();
+        assert(decoded == data);
+        return packed.size();
+    };
+    assert(packedSize(true) < packedSize(false));
+
+    // разрядность из заголовка потока проверяется
+    lzw::Decoder dec(lzw::Params{false, true, lzw::kDefaultWideBits});
+    ByteVec out;
+    const ByteVec badWidth = {40, 0x61, 0x00};
+    expectThrows(ErrorCode::Corrupted, [&]{ dec.feed(badWidth, out); });
+    // допустимая для lzw, но шире, чем пишет формат: отказ до выделения словаря
+    for (std::uint8_t bits : {std::uint8_t(lzw::kDefaultWideBits + 1), std::uint8_t(lzw::kMaxWideBits)}) {
+        lzw::Decoder wide(lzw::Params{false, true, lzw::kDefaultWideBits});
+        const ByteVec tooWide = {bits, 0x61, 0x00};
+        expectThrows(ErrorCode::Corrupted, [&]{ wide.feed(tooWide, out); });
+    }
+    expectThrows(ErrorCode::InvalidArg, [&]{ lzw::Encoder(lzw::Params{false, true, 30}); });
+}
+
+void test_auto_picks_by_objective() {
+    // несжимаемое — хранится как есть, и лишь на размер заголовка больше
+    ByteVec noise(300000);
+    std::mt19937 rng(21);
+    for (auto& b : noise) b = static_cast<std::uint8_t>(rng());
+    FileContent f;
+    f.replaceAll(noise);
+    assert(chooseAlgo(f) == CompAlgo::STORED);
+    compressInplace(f, CompAlgo::AUTO);
+    assert(f.read(4, 1)[0] == static_cast<std::uint8_t>(CompAlgo::STORED));
+    assert(f.size() == noise.size() + 21 + 12 * 2);
+    uncompressInplace(f);
+    assert(f.bytes() == noise);
+
+    // текст: за размер — энтропийный кодек, за скорость — LZ_FAST
+    FileContent text;
+    text.replaceAll(sampleText(600000));
+    assert(chooseAlgo(text, AutoObjective{0.0}) == CompAlgo::LZ_HUFF);
+    assert(chooseAlgo(text, AutoObjective{10.0}) == CompAlgo::LZ_FAST);
+    assertRoundtripAlgo(text.bytes(), CompAlgo::AUTO);
+}
+
+void test_incompressible_is_stored() {
+    ByteVec noise(200000);
+    std::mt19937 rng(17);
+    for (auto& b : noise) b = static_cast<std::uint8_t>(rng());
+    FileContent f;
+    f.replaceAll(noise);
+    assert(looksIncompressible(f));
+    compressInplace(f, CompAlgo::LZW_VAR_ALL);
+    assert(f.read(4, 1)[0] == static_cast<std::uint8_t>(CompAlgo::STORED));
+    assert(f.size() == noise.size() + 21 + 12);
+
+    // текст, затем шум: предпроверка пропускает, но второй блок не сжимается
+    // и хранится как есть, помеченный в таблице
+    ByteVec mixed = sampleText(kCompressBlock);
+    mixed.insert(mixed.end(), noise.begin(), noise.end());
+    for (CompAlgo algo : {CompAlgo::LZW_VAR_ALL, CompAlgo::LZ_FAST}) {
+        FileContent m;
+        m.replaceAll(mixed);
+        assert(!looksIncompressible(m));
+        compressInplace(m, algo);
+        auto table = m.read(21, 24);
+        assert((table[7] & 0x80) == 0 && (table[19] & 0x80) != 0);
+        assert(m.size() < kCompressBlock / 2 + noise.size() + 21 + 24);
+
+        ByteVec window(1000);
+        const std::size_t off = kCompressBlock + 5000;
+        assert(readDecompressed(m, off, window) == window.size());
+        assert(std::equal(window.begin(), window.end(), mixed.begin() + static_cast<long>(off)));
+        DecompressReader reader(m);
+        ByteVec all(mixed.size() + 1);
+        std::size_t got = 0;
+        while (std::size_t n = reader.read(std::span<std::uint8_t>(all.data() + got, all.size() - got))) got += n;
+        assert(got == mixed.size() && std::equal(mixed.begin(), mixed.end(), all.begin()));
+        uncompressInplace(m);
+        assert(m.bytes() == mixed);
+    }
+}
+
+void test_block_table_corruption() {
+    FileContent f;
+    f.replaceAll(sampleText(2 * kCompressBlock));
+    compressInplace(f, CompAlgo::LZW_VAR_ALL);
+    auto bytes = f.bytes();
+    // конец первого блока указывает за конец второго
+    bytes[21 + 6] = 0x7F;
+    FileContent broken;
+    broken.replaceAll(bytes);
+    expectThrows(ErrorCode::Corrupted, [&]{ uncompressInplace(broken); });
+}
+
 } // namespace
 
 struct NamedTest {
@@ -172,7 +701,26 @@ int main(int argc, char** argv) {
         {"kwkwk", &test_kwkwk_pattern},
         {"payload_corruption", &test_payload_corruption_detection},
         {"length_mismatch", &test_length_mismatch_detection},
-        {"functional_multi", &test_functional_roundtrip_multiple}
+        {"functional_multi", &test_functional_roundtrip_multiple},
+        {"streaming_chunks", &test_streaming_matches_whole_input},
+        {"reader_small_reads", &test_decompress_reader_small_reads},
+        {"format_stable", &test_format_is_stable},
+        {"legacy_v3", &test_reads_legacy_v3},
+        {"legacy_v4", &test_reads_legacy_v4},
+        {"append", &test_append_rewrites_only_tail},
+        {"crc32c", &test_crc32c_vectors},
+        {"checksum", &test_checksum_catches_stored_damage},
+        {"random_access", &test_random_access_by_block},
+        {"block_table", &test_block_table_corruption},
+        {"threads_deterministic", &test_threads_do_not_change_output},
+        {"fast_binary", &test_fast_binary_and_overlaps},
+        {"fast_bad_offsets", &test_fast_rejects_bad_offsets},
+        {"huff_ratio", &test_huff_ratio_and_skewed_alphabet},
+        {"huff_damage", &test_huff_rejects_damage},
+        {"wide_clear", &test_wide_clear_resets_stale_dictionary},
+        {"auto", &test_auto_picks_by_objective},
+        {"incompressible", &test_incompressible_is_stored},
+        {"reader_window", &test_reader_history_window}
     };
 
     auto runNamed = [](const NamedTest& t) {
@@ -4,6 +4,7 @@
 
 #include <cassert>
 #include <iostream>
+#include <string>
 
 static void test_copy_file_into_directory() {
     Vfs v;
@@ -55,10 +56,70 @@ static void test_copy_error_cases() {
     expectThrows(ErrorCode::InvalidArg, [&]{ v.cp("/file.txt", "/file.txt/data"); });
 }
 
+static void test_copy_shares_content_until_write() {
+    Vfs v;
+    v.createFile("/big.bin");
+    v.writeFile("/big.bin", std::string(4096, 'x'), false);
+    v.cp("/big.bin", "/copy.bin");
+
+    auto src = v.resolve("/big.bin");
+    auto dup = v.resolve("/copy.bin");
+    assert(dup->content.sharesStorageWith(src->content));
+
+    v.writeFile("/copy.bin", "y", true);
+    assert(!dup->content.sharesStorageWith(src->content));
+    assert(v.readFile("/big.bin") == std::string(4096, 'x'));
+    assert(v.readFile("/copy.bin") == std::string(4096, 'x') + "y");
+}
+
+static void test_lazy_copy_materializes_on_access() {
+    Vfs v;
+    v.mkdir("/src");
+    v.mkdir("/src/sub");
+    v.createFile("/src/sub/a.txt");
+    v.writeFile("/src/sub/a.txt", "original", false);
+
+    v.cp("/src", "/lazy", Vfs::CopyMode::Lazy);
+    auto lazy = v.resolve("/lazy", Vfs::ResolveKind::Directory);
+    assert(lazy && lazy->children.empty());
+    assert(lazy->fileProps.fileCount == 1 && lazy->fileProps.dirCount == 1);
+
+    assert(v.readFile("/lazy/sub/a.txt") == "original");
+    assert(v.findNodesByName("a.txt").size() == 2);
+}
+
+static void test_lazy_copy_is_a_snapshot() {
+    Vfs v;
+    v.mkdir("/src");
+    v.mkdir("/src/deep");
+    v.createFile("/src/deep/f.txt");
+    v.writeFile("/src/deep/f.txt", "v1", false);
+
+    v.cp("/src", "/snap", Vfs::CopyMode::Lazy);
+    // изменения источника после копирования не должны быть видны в копии
+    v.writeFile("/src/deep/f.txt", "v2", false);
+    v.createFile("/src/deep/new.txt");
+    v.rm("/src/deep/new.txt");
+    v.mkdir("/src/extra");
+
+    assert(v.readFile("/snap/deep/f.txt") == "v1");
+    assert(!v.resolve("/snap/extra"));
+    assert(v.readFile("/src/deep/f.txt") == "v2");
+
+    // и наоборот: запись в копию не трогает источник
+    v.cp("/src", "/snap2", Vfs::CopyMode::Lazy);
+    v.writeFile("/snap2/deep/f.txt", "v3", false);
+    assert(v.readFile("/src/deep/f.txt") == "v2");
+    assert(v.readFile("/snap2/deep/f.txt") == "v3");
+}
+
 int main() {
     test_copy_file_into_directory();
     test_copy_directory_new_location();
     test_copy_name_conflict();
     test_copy_error_cases();
+    test_copy_shares_content_until_write();
+    test_lazy_copy_materializes_on_access();
+    test_lazy_copy_is_a_snapshot();
     std::cout << "[OK] test_cp\n";
 }
@@ -0,0 +1,122 @@
+#include "Vfs.hpp"
+#include "BlobStore.hpp"
+#include "Errors.hpp"
+#include "TestUtils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+static void test_identical_writes_share_one_blob() {
+    Vfs v;
+    v.setDedup(true);
+    const std::string asset(10000, 'Q');
+    for (int i = 0; i < 5; ++i) {
+        auto path = "/asset" + std::to_string(i);
+        v.createFile(path);
+        v.writeFile(path, asset, false);
+    }
+    auto a = v.resolve("/asset0");
+    auto b = v.resolve("/asset4");
+    assert(a->content.sharesStorageWith(b->content));
+    assert(a->content.physicalBytes() * 5 <= asset.size());
+
+    auto st = v.dedupStats();
+    assert(st.files == 5);
+    assert(st.logicalBytes == 5 * asset.size());
+    assert(st.physicalBytes == asset.size());
+    assert(st.blobs == 1);
+}
+
+static void test_write_after_dedup_is_copy_on_write() {
+    Vfs v;
+    v.setDedup(true);
+    const std::string same(200, 's');
+    v.createFile("/a");
+    v.createFile("/b");
+    v.writeFile("/a", same, false);
+    v.writeFile("/b", same, false);
+    v.writeFile("/b", "!", true);
+    assert(v.readFile("/a") == same);
+    assert(v.readFile("/b") == same + "!");
+    assert(v.dedupStats().blobs == 2);
+
+    // снова одинаковые — снова один блоб
+    v.writeFile("/b", same, false);
+    assert(v.dedupStats().blobs == 1);
+}
+
+static void test_enable_dedup_collapses_existing_files() {
+    Vfs v;
+    v.mkdir("/d");
+    v.createFile("/d/x.json");
+    v.createFile("/d/y.json");
+    std::string json = "{\"items\": [";
+    for (int i = 0; i < 20; ++i) json += std::to_string(i) + ", ";
+    json += "0]}";
+    v.writeFile("/d/x.json", json, false);
+    v.writeFile("/d/y.json", json, false);
+    assert(v.dedupStats().blobs == 2);
+    v.setDedup(true);
+    auto st = v.dedupStats();
+    assert(st.blobs == 1);
+    assert(st.logicalBytes == 2 * st.physicalBytes);
+}
+
+static void test_hash_distinguishes_content() {
+    std::string a(100, 'a'), b(100, 'a');
+    b[57] = 'b';
+    auto ha = BlobStore::hashBytes(reinterpret_cast<const std::uint8_t*>(a.data()), a.size());
+    auto hb = BlobStore::hashBytes(reinterpret_cast<const std::uint8_t*>(b.data()), b.size());
+    assert(ha != hb);
+}
+
+static void test_inline_files_are_not_blobs() {
+    Vfs v;
+    v.setDedup(true);
+    v.createFile("/flag1");
+    v.createFile("/flag2");
+    v.writeFile("/flag1", "on", false);
+    v.writeFile("/flag2", "on", false);
+    auto st = v.dedupStats();
+    // крошечные файлы лежат в самом узле, делить там нечего
+    assert(st.logicalBytes == 4);
+    assert(st.physicalBytes == 4);
+}
+
+static void test_dead_buckets_are_dropped() {
+    // каждый буфер живёт один intern: индекс не должен расти с их числом
+    BlobStore store;
+    std::size_t peak = 0;
+    for (std::uint32_t i = 0; i < 20000; ++i) {
+        auto buf = std::make_shared<BlobStore::Buffer>(64, static_cast<std::uint8_t>(i));
+        std::memcpy(buf->data(), &i, sizeof(i));
+        store.intern(buf);
+        peak = std::max(peak, store.bucketCount());
+    }
+    assert(peak <= 2 * 1024);
+
+    // живые блобы при вычистке не теряются
+    auto kept = std::make_shared<BlobStore::Buffer>(64, 0xAB);
+    assert(store.intern(kept) == kept);
+    for (std::uint32_t i = 0; i < 5000; ++i) {
+        auto buf = std::make_shared<BlobStore::Buffer>(64, 0);
+        std::memcpy(buf->data(), &i, sizeof(i));
+        store.intern(buf);
+    }
+    auto same = std::make_shared<BlobStore::Buffer>(64, 0xAB);
+    assert(store.intern(same) == kept);
+}
+
+int main() {
+    test_identical_writes_share_one_blob();
+    test_write_after_dedup_is_copy_on_write();
+    test_enable_dedup_collapses_existing_files();
+    test_hash_distinguishes_content();
+    test_inline_files_are_not_blobs();
+    test_dead_buckets_are_dropped();
+    std::cout << "[OK] test_dedup\n";
+}
@@ -0,0 +1,193 @@
+#include "Compression.hpp"
+#include "DictTrainer.hpp"
+#include "Errors.hpp"
+#include "FileContent.hpp"
+#include "Vfs.hpp"
+#include "TestUtils.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+using ByteVec = std::vector<std::uint8_t>;
+
+// Мелкие JSON-записи одной схемы: по отдельности почти не сжимаются,
+// зато повторяют одни и те же ключи и значения из небольших наборов.
+std::vector<std::string> smallRecords(std::size_t count, std::uint32_t seed) {
+    static const char* kEvents[] = {"login", "logout", "page_view", "purchase", "search"};
+    static const char* kRegions[] = {"eu-west-1", "us-east-1", "ap-south-1"};
+    static const char* kAgents[] = {"Mozilla/5.0 (X11; Linux x86_64)", "Mozilla/5.0 (Windows NT 10.0; Win64; x64)",
+                                    "curl/8.4.0"};
+    std::mt19937 rng(seed);
+    std::vector<std::string> out;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::string r = "{\"id\":" + std::to_string(100000 + i) +
+                        ",\"user\":\"user_" + std::to_string(rng() % 5000) +
+                        "\",\"event\":\"" + kEvents[rng() % 5] +
+                        "\",\"timestamp\":\"2024-03-" + std::to_string(10 + rng() % 20) + "T12:" +
+                        std::to_string(10 + rng() % 50) + ":00Z\",\"region\":\"" + kRegions[rng() % 3] +
+                        "\",\"status\":\"ok\",\"user_agent\":\"" + kAgents[rng() % 3] +
+                        "\",\"session\":{\"duration_ms\":" + std::to_string(rng() % 100000) +
+                        ",\"pages\":" + std::to_string(rng() % 40) + ",\"authenticated\":true}}\n";
+        out.push_back(std::move(r));
+    }
+    return out;
+}
+
+DictionaryPtr trainOn(const std::vector<std::string>& files) {
+    std::vector<std::span<const std::uint8_t>> samples;
+    for (const auto& f : files) samples.emplace_back(reinterpret_cast<const std::uint8_t*>(f.data()), f.size());
+    return makeDictionary(trainDictionary(samples, kMaxDictionary));
+}
+
+DictionaryLookup lookupOf(const DictionaryPtr& dict) {
+    return [dict](std::uint32_t id) { return id == dict->id ? dict : nullptr; };
+}
+
+void test_trainer_limits() {
+    auto files = smallRecords(200, 1);
+    std::vector<std::span<const std::uint8_t>> samples;
+    for (const auto& f : files) samples.emplace_back(reinterpret_cast<const std::uint8_t*>(f.data()), f.size());
+    auto dict = trainDictionary(samples, 1024);
+    assert(!dict.empty() && dict.size() <= 1024);
+    assert(trainDictionary({}, 1024).empty());
+    // id зависит только от байтов
+    assert(makeDictionary(dict)->id == dictionaryId(dict));
+    expectThrows(ErrorCode::InvalidArg, [] { makeDictionary(ByteVec(kMaxDictionary + 1, 'x')); });
+}
+
+void test_roundtrip_and_missing_dictionary() {
+    auto files = smallRecords(300, 2);
+    auto dict = trainOn(files);
+    for (std::size_t i = 0; i < 20; ++i) {
+        FileContent f;
+        f.assignText(files[i]);
+        compressInplace(f, CompAlgo::LZ_DICT, 1, {}, dict);
+        assert(isCompressed(f));
+        std::string part(10, '\0');
+        auto got = readDecompressed(f, 5, std::span<std::uint8_t>(reinterpret_cast<std::uint8_t*>(part.data()),
+                                                                   part.size()), lookupOf(dict));
+        assert(got == part.size() && part == files[i].substr(5, 10));
+        // без словаря файл не открыть
+        FileContent copy = f;
+        expectThrows(ErrorCode::NotFound, [&] { uncompressInplace(copy, 1); });
+        uncompressInplace(f, 1, lookupOf(dict));
+        assert(f.asText() == files[i]);
+    }
+    // другой словарь под тем же id — ошибка, а не чужие байты
+    FileContent f;
+    f.assignText(files[0]);
+    compressInplace(f, CompAlgo::LZ_DICT, 1, {}, dict);
+    auto other = makeDictionary(ByteVec(64, 'z'));
+    expectThrows(ErrorCode::Corrupted, [&] {
+        uncompressInplace(f, 1, [other](std::uint32_t) { return other; });
+    });
+    FileContent plain;
+    plain.assignText(files[0]);
+    expectThrows(ErrorCode::InvalidArg, [&] { compressInplace(plain, CompAlgo::LZ_DICT, 1, {}); });
+    // другим алгоритмам словарь не передаётся: файл читается и без него
+    compressInplace(plain, CompAlgo::LZ_FAST, 1, {}, dict);
+    uncompressInplace(plain, 1);
+    assert(plain.asText() == files[0]);
+}
+
+void test_small_files_ratio() {
+    // словарь учится на одной части выборки, проверяется на другой
+    auto training = smallRecords(1000, 3);
+    auto files = smallRecords(1000, 4);
+    auto dict = trainOn(training);
+    std::size_t original = 0, plain = 0, primed = 0;
+    for (const auto& text : files) {
+        assert(text.size() < 1024);
+        original += text.size();
+        FileContent a;
+        a.assignText(text);
+        compressInplace(a, CompAlgo::LZ_FAST, 1, {});
+        plain += a.size();
+        FileContent b;
+        b.assignText(text);
+        compressInplace(b, CompAlgo::LZ_DICT, 1, {}, dict);
+        primed += b.size();
+    }
+    std::cout << "small files: " << original << " -> fast " << plain << ", dict " << primed << "\n";
+    assert(primed * 3 < plain);
+}
+
+void test_vfs_train_and_compress() {
+    Vfs v;
+    v.mkdir("/logs");
+    auto files = smallRecords(400, 5);
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        const std::string path = "/logs/r" + std::to_string(i) + ".json";
+        v.createFile(path);
+        v.writeFile(path, files[i], false);
+    }
+    const std::uint32_t id = v.trainDictionary("/logs");
+    assert(v.resolve(Vfs::kDictDir)->fileProps.fileCount == 1);
+    // повторное обучение на тех же файлах даёт тот же словарь
+    assert(v.trainDictionary("/logs") == id);
+
+    v.compress("/", CompAlgo::LZ_DICT, 1, {}, id);
+    assert(isCompressed(v.resolve("/logs/r7.json")->content));
+    // сам словарь не сжимается
+    assert(v.loadDictionary(id)->id == id);
+
+    v.decompress("/", 1);
+    for (std::size_t i = 0; i < files.size(); i += 37) {
+        assert(v.readFile("/logs/r" + std::to_string(i) + ".json") == files[i]);
+    }
+    expectThrows(ErrorCode::NotFound, [&] { v.compress("/logs", CompAlgo::LZ_DICT, 1, {}, id + 1); });
+}
+
+void test_vfs_policy_append_with_dictionary() {
+    Vfs v;
+    v.mkdir("/logs");
+    auto files = smallRecords(200, 9);
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        const std::string path = "/logs/r" + std::to_string(i) + ".json";
+        v.createFile(path);
+        v.writeFile(path, files[i], false);
+    }
+    const std::uint32_t id = v.trainDictionary("/logs");
+    CompressionPolicy policy;
+    policy.enabled = true;
+    policy.algo = CompAlgo::LZ_DICT;
+    policy.dictId = id;
+    v.setCompressionPolicy("/logs", policy);
+
+    v.createFile("/logs/all.json");
+    std::string expected;
+    for (const auto& rec : files) {
+        v.writeFile("/logs/all.json", rec, true);
+        expected += rec;
+    }
+    assert(isCompressed(v.resolve("/logs/all.json")->content));
+    assert(v.readFile("/logs/all.json") == expected);
+
+    // удалённый словарь не остаётся в кэше
+    v.rm(Vfs::kDictDir);
+    expectThrows(ErrorCode::NotFound, [&] { (void)v.loadDictionary(id); });
+    // без словаря запись проходит целиком, файл просто не сжимается
+    v.createFile("/logs/late.json");
+    v.writeFile("/logs/late.json", expected, false);
+    auto late = v.resolve("/logs/late.json");
+    assert(!isCompressed(late->content) && late->fileProps.byteSize == expected.size());
+    assert(v.readFile("/logs/late.json") == expected);
+}
+
+} // namespace
+
+int main() {
+    test_trainer_limits();
+    test_roundtrip_and_missing_dictionary();
+    test_small_files_ratio();
+    test_vfs_train_and_compress();
+    test_vfs_policy_append_with_dictionary();
+    std::cout << "[OK] test_dictionary\n";
+}
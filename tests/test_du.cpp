@@ -0,0 +1,123 @@
+#include "Vfs.hpp"
+#include "Errors.hpp"
+#include "TestUtils.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+
+static void assertTotals(const Vfs& v, const std::string& path,
+                         std::size_t bytes, std::size_t files, std::size_t dirs) {
+    auto n = v.resolve(path, Vfs::ResolveKind::Directory);
+    assert(n && !n->isFile);
+    if (n->fileProps.byteSize != bytes || n->fileProps.fileCount != files || n->fileProps.dirCount != dirs) {
+        std::cerr << path << ": bytes=" << n->fileProps.byteSize << " files=" << n->fileProps.fileCount
+                  << " dirs=" << n->fileProps.dirCount << "\n";
+    }
+    assert(n->fileProps.byteSize == bytes);
+    assert(n->fileProps.fileCount == files);
+    assert(n->fileProps.dirCount == dirs);
+}
+
+static void test_totals_on_create_and_write() {
+    Vfs v;
+    v.mkdir("/a");
+    v.mkdir("/a/b");
+    v.createFile("/a/b/f.txt");
+    v.writeFile("/a/b/f.txt", "hello", false);
+    v.createFile("/a/g.txt");
+    v.writeFile("/a/g.txt", "xy", false);
+    v.writeFile("/a/g.txt", "z", true);
+
+    assertTotals(v, "/", 8, 2, 2);
+    assertTotals(v, "/a", 8, 2, 1);
+    assertTotals(v, "/a/b", 5, 1, 0);
+
+    v.writeFile("/a/b/f.txt", "hi", false);
+    assertTotals(v, "/", 5, 2, 2);
+    assertTotals(v, "/a/b", 2, 1, 0);
+}
+
+static void test_totals_on_rm_and_mv() {
+    Vfs v;
+    v.mkdir("/src");
+    v.mkdir("/src/inner");
+    v.createFile("/src/inner/data");
+    v.writeFile("/src/inner/data", "12345", false);
+    v.mkdir("/dst");
+
+    v.mv("/src/inner", "/dst");
+    assertTotals(v, "/src", 0, 0, 0);
+    assertTotals(v, "/dst", 5, 1, 1);
+    assertTotals(v, "/", 5, 1, 3);
+
+    v.rm("/dst/inner");
+    assertTotals(v, "/dst", 0, 0, 0);
+    assertTotals(v, "/", 0, 0, 2);
+}
+
+static void test_totals_on_cp_and_compress() {
+    Vfs v;
+    v.mkdir("/p");
+    v.mkdir("/p/q");
+    v.createFile("/p/q/a.txt");
+    v.writeFile("/p/q/a.txt", "aaaa", false);
+    v.createFile("/p/b.txt");
+    v.writeFile("/p/b.txt", "bb", false);
+
+    v.cp("/p", "/copy");
+    assertTotals(v, "/copy", 6, 2, 1);
+    assertTotals(v, "/", 12, 4, 4);
+
+    v.compress("/p/q/a.txt");
+    auto f = v.resolve("/p/q/a.txt");
+    assertTotals(v, "/p/q", f->content.size(), 1, 0);
+    v.decompress("/p/q/a.txt");
+    assertTotals(v, "/", 12, 4, 4);
+}
+
+static void test_directory_char_totals() {
+    Vfs v;
+    v.mkdir("/d");
+    v.createFile("/d/x");
+    v.writeFile("/d/x", "abc", false);
+    auto d = v.resolve("/d");
+    assert(d->fileProps.charCount == 3);
+}
+
+static void test_memory_usage() {
+    Vfs v;
+    v.mkdir("/m");
+    for (int i = 0; i < 10; ++i) {
+        std::string p = "/m/f" + std::to_string(i);
+        v.createFile(p);
+        v.writeFile(p, "tiny", false);
+    }
+    auto small = v.memoryUsage("/m");
+    assert(small.nodes == 11);
+    assert(small.inlineFiles == 10);
+    assert(small.contentBytes == 0);
+
+    v.writeFile("/m/f0", std::string(1000, 'x'), false);
+    auto grown = v.memoryUsage("/m");
+    assert(grown.inlineFiles == 9);
+    assert(grown.contentBytes >= 1000);
+    assert(v.memoryUsage().total() >= grown.total());
+}
+
+static void test_memory_usage_missing_path() {
+    Vfs v;
+    expectThrows(ErrorCode::PathError, [&]{ (void)v.memoryUsage("/nope"); });
+    v.mkdir("/d");
+    expectThrows(ErrorCode::PathError, [&]{ (void)v.memoryUsage("/d/nope"); });
+}
+
+int main() {
+    test_totals_on_create_and_write();
+    test_totals_on_rm_and_mv();
+    test_totals_on_cp_and_compress();
+    test_directory_char_totals();
+    test_memory_usage();
+    test_memory_usage_missing_path();
+    std::cout << "[OK] test_du\n";
+}
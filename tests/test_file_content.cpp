@@ -0,0 +1,227 @@
+#include "FileContent.hpp"
+#include "Errors.hpp"
+#include "TestUtils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+using ByteVec = std::vector<std::uint8_t>;
+constexpr std::size_t kPage = FileContent::kPageSize;
+
+void assertSame(const FileContent& f, const ByteVec& ref) {
+    assert(f.size() == ref.size());
+    assert(f.read(0, ref.size()) == ref);
+    assert(f.bytes() == ref);
+}
+
+void test_appends_switch_to_pages() {
+    FileContent f;
+    ByteVec ref;
+    for (int i = 0; i < 5000; ++i) {
+        ByteVec line(37, static_cast<std::uint8_t>(i));
+        f.append(line);
+        ref.insert(ref.end(), line.begin(), line.end());
+    }
+    assert(f.paged());
+    assert(f.pageCount() == (ref.size() + kPage - 1) / kPage);
+    assertSame(f, ref);
+}
+
+void test_random_writes_match_reference() {
+    FileContent f;
+    ByteVec ref;
+    std::mt19937 rng(7);
+    for (int step = 0; step < 300; ++step) {
+        std::size_t off = ref.empty() ? 0 : rng() % (ref.size() + 1);
+        ByteVec chunk(rng() % (kPage / 2) + 1);
+        for (auto& b : chunk) b = static_cast<std::uint8_t>(rng());
+        f.write(off, chunk);
+        if (off + chunk.size() > ref.size()) ref.resize(off + chunk.size());
+        std::copy(chunk.begin(), chunk.end(), ref.begin() + static_cast<long>(off));
+    }
+    assertSame(f, ref);
+    auto mid = f.read(kPage - 3, 10);
+    assert(mid == ByteVec(ref.begin() + static_cast<long>(kPage - 3), ref.begin() + static_cast<long>(kPage + 7)));
+}
+
+void test_truncate_across_pages() {
+    FileContent f;
+    ByteVec ref(3 * kPage + 100, 0x5A);
+    f.replaceAll(ref);
+    assert(f.paged());
+
+    f.truncate(kPage + 1);
+    ref.resize(kPage + 1);
+    assertSame(f, ref);
+
+    f.truncate(10);
+    ref.resize(10);
+    assert(!f.paged());
+    assertSame(f, ref);
+
+    f.truncate(2 * kPage);
+    ref.resize(2 * kPage, 0);
+    assertSame(f, ref);
+}
+
+void test_copy_shares_pages_until_write() {
+    FileContent a;
+    const ByteVec init(4 * kPage, 1);
+    a.replaceAll(init);
+    FileContent b = a;
+    assert(b.sharesStorageWith(a));
+    assert(a.physicalBytes() == 2 * kPage);
+
+    b.write(kPage + 5, ByteVec{9});
+    // разделение разорвано только у одной страницы
+    assert(a.physicalBytes() == 2 * kPage + kPage / 2);
+    assert(a.read(kPage + 5, 1)[0] == 1);
+    assert(b.read(kPage + 5, 1)[0] == 9);
+}
+
+void test_bounds() {
+    FileContent f;
+    f.replaceAll(ByteVec(kPage + 1, 0));
+    expectThrows(ErrorCode::OutOfRange, [&]{ (void)f.read(kPage + 2, 1); });
+    expectThrows(ErrorCode::OutOfRange, [&]{ (void)f.view(kPage + 2, 1); });
+}
+
+void test_span_views_and_read_into() {
+    FileContent f;
+    ByteVec ref(2 * kPage + 10);
+    for (std::size_t i = 0; i < ref.size(); ++i) ref[i] = static_cast<std::uint8_t>(i * 31);
+    f.append(std::span<const std::uint8_t>(ref));
+
+    auto v = f.view(kPage - 4, 100);
+    assert(v.size() == 4);  // обрезано границей страницы
+    assert(v.data()[0] == ref[kPage - 4]);
+
+    ByteVec dst(100);
+    assert(f.readInto(kPage - 4, dst) == 100);
+    assert(std::equal(dst.begin(), dst.end(), ref.begin() + static_cast<long>(kPage - 4)));
+    assert(f.readInto(ref.size() - 3, dst) == 3);
+    assert(f.view(ref.size(), 5).empty());
+
+    std::uint32_t magic = 0xCAFEBABE;
+    f.writeValue(kPage - 2, magic);
+    assert(f.readValue<std::uint32_t>(kPage - 2) == magic);
+    expectThrows(ErrorCode::ReadError, [&]{ (void)f.readValue<std::uint64_t>(f.size() - 4); });
+}
+
+void test_replace_all_moves_buffer() {
+    ByteVec big(3 * kPage, 0x11);
+    const auto* raw = big.data();
+    FileContent f;
+    f.replaceAll(std::move(big));
+    assert(f.view(0, 1).data() == raw);
+    assert(f.size() == 3 * kPage);
+
+    // дозапись режет крупный буфер на страницы один раз
+    f.append(ByteVec{0x22});
+    assert(f.paged());
+    assert(f.read(3 * kPage, 1)[0] == 0x22);
+    assert(f.read(0, 1)[0] == 0x11);
+}
+
+void test_small_files_stay_inline() {
+    FileContent f;
+    assert(f.isInline() && f.heapBytes() == 0);
+    f.appendText("hello");
+    assert(f.isInline() && f.heapBytes() == 0);
+    assert(f.asText() == "hello");
+
+    ByteVec ref(f.bytes());
+    ByteVec tail(FileContent::kInlineCapacity - ref.size(), 0x42);
+    f.append(tail);
+    ref.insert(ref.end(), tail.begin(), tail.end());
+    assert(f.isInline());
+    assertSame(f, ref);
+
+    // один лишний байт — содержимое уходит в кучу
+    f.append(ByteVec{0x43});
+    ref.push_back(0x43);
+    assert(!f.isInline() && f.heapBytes() > 0);
+    assertSame(f, ref);
+
+    f.truncate(3);
+    ref.resize(3);
+    assert(f.isInline() && f.heapBytes() == 0);
+    assertSame(f, ref);
+
+    // копия встроенного содержимого независима
+    FileContent g = f;
+    g.write(0, ByteVec{'X'});
+    assert(f.read(0, 1)[0] == 'h');
+    assert(!g.sharesStorageWith(f));
+}
+
+void test_inline_footprint() {
+    static_assert(sizeof(FileContent) <= 64);
+    FileContent f;
+    f.replaceAll(ByteVec(FileContent::kInlineCapacity, 1));
+    assert(f.isInline());
+    f.replaceAll(ByteVec(FileContent::kInlineCapacity + 1, 1));
+    assert(!f.isInline() && !f.paged());
+}
+
+void test_sparse_writes_leave_holes() {
+    FileContent f;
+    const std::size_t far = 100 * kPage + 10;
+    f.write(far, ByteVec{'e', 'n', 'd'});
+    assert(f.size() == far + 3);
+    assert(f.allocatedBytes() == 13);
+    assert(f.heapBytes() < 4 * kPage);
+    assert(f.read(50 * kPage, 4) == ByteVec(4, 0));
+    assert(f.read(far - 2, 5) == (ByteVec{0, 0, 'e', 'n', 'd'}));
+
+    // запись в дыру выделяет только одну страницу
+    f.write(7 * kPage + 1, ByteVec{'x'});
+    assert(f.allocatedBytes() == kPage + 13);
+    assert(f.read(7 * kPage, 3) == (ByteVec{0, 'x', 0}));
+
+    std::size_t total = 0;
+    f.forEachChunk([&](const std::uint8_t*, std::size_t n) { total += n; });
+    assert(total == f.size());
+}
+
+void test_truncate_extends_with_hole() {
+    FileContent f;
+    f.assignText("head");
+    f.truncate(64ull * 1024 * 1024);
+    assert(f.size() == 64ull * 1024 * 1024);
+    assert(f.allocatedBytes() == kPage);
+    assert(f.read(0, 6) == (ByteVec{'h', 'e', 'a', 'd', 0, 0}));
+    assert(f.read(f.size() - 1, 1)[0] == 0);
+
+    // усечение внутрь дыры и обратно — по-прежнему нули
+    f.truncate(3 * kPage + 7);
+    f.write(3 * kPage + 7, ByteVec{1});
+    assert(f.read(3 * kPage, 8) == (ByteVec{0, 0, 0, 0, 0, 0, 0, 1}));
+    f.truncate(2);
+    assert(f.isInline() && f.asText() == "he");
+}
+
+} // namespace
+
+int main() {
+    test_appends_switch_to_pages();
+    test_random_writes_match_reference();
+    test_truncate_across_pages();
+    test_copy_shares_pages_until_write();
+    test_bounds();
+    test_span_views_and_read_into();
+    test_replace_all_moves_buffer();
+    test_small_files_stay_inline();
+    test_inline_footprint();
+    test_sparse_writes_leave_holes();
+    test_truncate_extends_with_hole();
+    std::cout << "[OK] test_file_content\n";
+}
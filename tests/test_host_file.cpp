@@ -0,0 +1,112 @@
+#include "Vfs.hpp"
+#include "HostFile.hpp"
+#include "Errors.hpp"
+#include "TestUtils.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t kPage = FileContent::kPageSize;
+
+std::string makeHostFile(const std::string& tag, const std::string& data) {
+    std::string path = "/tmp/vfs_host_" + tag + "_" + std::to_string(::getpid());
+    std::ofstream out(path, std::ios::binary);
+    out << data;
+    return path;
+}
+
+std::string readHostFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+std::string pattern(std::size_t n) {
+    std::string s(n, '\0');
+    for (std::size_t i = 0; i < n; ++i) s[i] = static_cast<char>('a' + i % 26);
+    return s;
+}
+
+void test_import_reads_from_mapping() {
+    const std::string data = pattern(3 * kPage + 123);
+    auto host = makeHostFile("read", data);
+    Vfs v;
+    v.mkdir("/data");
+    v.importHostFile(host, "/data/big.bin");
+    auto f = v.resolve("/data/big.bin");
+    assert(f->content.hostBacked());
+    assert(f->content.mappedBytes() == data.size());
+    // сами байты в куче не лежат — только таблица страниц
+    assert(f->content.heapBytes() < 1024);
+    assert(v.readFile("/data/big.bin") == data);
+    assert(f->fileProps.byteSize == data.size());
+    assert(v.resolve("/data")->fileProps.byteSize == data.size());
+    std::remove(host.c_str());
+}
+
+void test_writes_copy_only_touched_pages() {
+    const std::string data = pattern(4 * kPage);
+    auto host = makeHostFile("cow", data);
+    Vfs v;
+    v.importHostFile(host, "/f");
+    auto f = v.resolve("/f");
+    f->content.write(kPage + 10, std::vector<std::uint8_t>{'X', 'Y'});
+    assert(f->content.mappedBytes() == 3 * kPage);
+
+    std::string expect = data;
+    expect[kPage + 10] = 'X';
+    expect[kPage + 11] = 'Y';
+    assert(f->content.asText() == expect);
+    // файл хоста не изменился
+    assert(readHostFile(host) == data);
+
+    // копия разделяет отображение и не видит последующих записей
+    v.cp("/f", "/g");
+    f->content.write(0, std::vector<std::uint8_t>{'Z'});
+    assert(v.resolve("/g")->content.asText() == expect);
+    std::remove(host.c_str());
+}
+
+void test_truncate_and_extend_mapped() {
+    const std::string data = pattern(2 * kPage);
+    auto host = makeHostFile("trunc", data);
+    FileContent c;
+    c.mapHostFile(HostFile::open(host));
+    c.truncate(kPage + 5);
+    c.truncate(kPage + 10);
+    auto tail = c.read(kPage, 10);
+    for (std::size_t i = 0; i < 5; ++i) assert(tail[i] == static_cast<std::uint8_t>(data[kPage + i]));
+    for (std::size_t i = 5; i < 10; ++i) assert(tail[i] == 0);
+    std::remove(host.c_str());
+}
+
+void test_small_and_missing_host_files() {
+    auto host = makeHostFile("small", "tiny");
+    Vfs v;
+    v.importHostFile(host, "/t");
+    auto f = v.resolve("/t");
+    assert(f->content.isInline());
+    assert(v.readFile("/t") == "tiny");
+    std::remove(host.c_str());
+
+    expectThrows(ErrorCode::NotFound, [&]{ v.importHostFile("/nonexistent/host/file", "/x"); });
+    v.mkdir("/d");
+    auto again = makeHostFile("dir", "x");
+    expectThrows(ErrorCode::InvalidArg, [&]{ v.importHostFile(again, "/d"); });
+    std::remove(again.c_str());
+}
+
+} // namespace
+
+int main() {
+    test_import_reads_from_mapping();
+    test_writes_copy_only_touched_pages();
+    test_truncate_and_extend_mapped();
+    test_small_and_missing_host_files();
+    std::cout << "[OK] test_host_file\n";
+}
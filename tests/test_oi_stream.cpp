@@ -92,6 +92,54 @@ static void test_seek_beyond_file_reports_eof() {
     stream.Close();
 }
 
+static void test_read_decompressed() {
+    FileContent file;
+    std::string text;
+    for (int i = 0; i < 200; ++i) text += "line " + std::to_string(i) + "\n";
+    file.assignText(text);
+    compressInplace(file, CompAlgo::LZW_VAR_ALL);
+
+    OIStream stream(file, StreamMode::ReadDecompressed, 8);
+    stream.Open();
+    assert(stream.CanSeek());
+    assert(stream.ReadLine() == "line 0");
+    assert(stream.Tell() == 7);
+    std::string rest;
+    char c;
+    while (stream.ReadChar(c)) rest.push_back(c);
+    assert("line 0\n" + rest == text);
+    assert(stream.Eof());
+    assert(stream.Seek(0) == 0);
+    assert(stream.ReadLine() == "line 0");
+    expectThrows(ErrorCode::InvalidArg, [&]{ stream.WriteByte(1); });
+    stream.Close();
+}
+
+static void test_seek_decompressed_blocks() {
+    FileContent file;
+    std::string text;
+    for (int i = 0; text.size() < 3 * kCompressBlock; ++i) text += "record " + std::to_string(i) + "\n";
+    file.assignText(text);
+    compressInplace(file, CompAlgo::LZW_VAR_ALL);
+
+    OIStream stream(file, StreamMode::ReadDecompressed, 64);
+    stream.Open();
+    // позиция в третьем блоке, затем назад в первый
+    std::size_t pos = text.find("record 59000\n");
+    assert(pos != std::string::npos && pos > 2 * kCompressBlock);
+    assert(stream.Seek(pos) == pos);
+    assert(stream.ReadLine() == "record 59000");
+    pos = text.find("record 7\n");
+    stream.Seek(pos);
+    assert(stream.ReadLine() == "record 7");
+    assert(stream.Tell() == pos + 9);
+    stream.Seek(text.size() + 100);
+    std::uint8_t b;
+    assert(!stream.ReadByte(b));
+    assert(stream.Eof());
+    stream.Close();
+}
+
 int main() {
     try {
         test_read_empty_stream();
@@ -101,6 +149,8 @@ int main() {
         test_write_multiple_buffers();
         test_seek_and_overwrite();
         test_seek_beyond_file_reports_eof();
+        test_read_decompressed();
+        test_seek_decompressed_blocks();
         std::cout << "OIStream tests passed\n";
     } catch (const VfsException& ex) {
         handleException(ex);
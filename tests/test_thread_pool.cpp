@@ -0,0 +1,86 @@
+#include "ThreadPool.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void test_every_index_once() {
+    for (unsigned threads : {1u, 2u, 5u}) {
+        ThreadPool pool(threads);
+        assert(pool.size() == threads);
+        // несколько циклов подряд на одном пуле
+        for (std::size_t n : {0u, 1u, 3u, 1000u}) {
+            std::vector<std::atomic<int>> hits(n);
+            std::atomic<bool> badWorker{false};
+            pool.parallelFor(n, [&](std::size_t i, unsigned worker) {
+                if (worker >= pool.size()) badWorker = true;
+                ++hits[i];
+            });
+            assert(!badWorker);
+            for (auto& h : hits) assert(h == 1);
+        }
+    }
+}
+
+void test_exception_propagates() {
+    ThreadPool pool(4);
+    bool caught = false;
+    try {
+        pool.parallelFor(100, [](std::size_t i, unsigned) {
+            if (i == 42) throw std::runtime_error("boom");
+        });
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    assert(caught);
+    // пул остаётся рабочим
+    std::atomic<std::size_t> sum{0};
+    pool.parallelFor(10, [&](std::size_t i, unsigned) { sum += i; });
+    assert(sum == 45);
+}
+
+void test_limit_and_nesting() {
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> hits(200);
+    std::atomic<bool> badWorker{false};
+    pool.parallelFor(hits.size(), [&](std::size_t i, unsigned worker) {
+        if (worker >= 2) badWorker = true;
+        // вложенный цикл идёт на месте, в том же потоке
+        std::atomic<int> inner{0};
+        pool.parallelFor(3, [&](std::size_t, unsigned w) { if (w == 0) ++inner; });
+        if (inner != 3) badWorker = true;
+        ++hits[i];
+    }, 2);
+    assert(!badWorker);
+    for (auto& h : hits) assert(h == 1);
+}
+
+void test_shared_from_many_threads() {
+    // циклы общего пула из разных потоков идут по очереди
+    auto& pool = ThreadPool::shared();
+    assert(&pool == &ThreadPool::shared());
+    std::atomic<std::size_t> sum{0};
+    std::vector<std::thread> callers;
+    for (int t = 0; t < 4; ++t) {
+        callers.emplace_back([&]{
+            for (int k = 0; k < 20; ++k) pool.parallelFor(50, [&](std::size_t i, unsigned) { sum += i; });
+        });
+    }
+    for (auto& c : callers) c.join();
+    assert(sum == 4u * 20u * 1225u);
+}
+
+} // namespace
+
+int main() {
+    test_every_index_once();
+    test_exception_propagates();
+    test_limit_and_nesting();
+    test_shared_from_many_threads();
+    std::cout << "[OK] test_thread_pool\n";
+}
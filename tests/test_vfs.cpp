@@ -1,10 +1,15 @@
 #include "Vfs.hpp"
 #include "Errors.hpp"
+#include "FileCommands.hpp"
 #include "FileContent.hpp"
 #include "TestUtils.hpp"
+#include "Utf8.hpp"
 
 #include <cassert>
+#include <functional>
 #include <iostream>
+#include <random>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -28,6 +33,21 @@ static void test_empty_compression() {
     assert(vfs.readFile("empty.txt") == "");
 }
 
+static void test_compress_keeps_tiny_files() {
+    Vfs v;
+    v.createFile("/empty");
+    v.createFile("/ten");
+    v.writeFile("/ten", "0123456789", false);
+    v.compress("/", CompAlgo::STORED);
+    v.compress("/", CompAlgo::AUTO);
+    for (const auto& [path, size] : {std::pair{"/empty", 0}, std::pair{"/ten", 10}}) {
+        auto f = v.resolve(path);
+        assert(!isCompressed(f->content));
+        assert(f->content.size() == static_cast<std::size_t>(size) && f->fileProps.byteSize == f->content.size());
+    }
+    assert(v.readFile("/ten") == "0123456789");
+}
+
 static void test_append_and_read_offset() {
     Vfs vfs;
     vfs.createFile("data.txt");
@@ -63,7 +83,10 @@ static void test_filecontent_bounds_checks() {
     FileContent f;
     expectThrows(ErrorCode::OutOfRange, [&]{ f.read(1, 1); });
     f.assignText("abc");
-    expectThrows(ErrorCode::OutOfRange, [&]{ f.write(5, {0x00}); });
+    // запись за концом оставляет дыру из нулей
+    f.write(5, {0x01});
+    assert(f.asText() == std::string("abc\0\0\x01", 6));
+    expectThrows(ErrorCode::OutOfRange, [&]{ f.read(7, 1); });
 }
 
 static void test_write_modes() {
@@ -111,9 +134,12 @@ static void test_compress_directory_recursive() {
     v.createFile("/docs/b.txt");
     v.mkdir("/docs/reports");
     v.createFile("/docs/reports/q1.txt");
-    v.writeFile("/docs/a.txt", "alpha", false);
-    v.writeFile("/docs/b.txt", "beta", false);
-    v.writeFile("/docs/reports/q1.txt", "inner", false);
+    // содержимое должно сжиматься, иначе compress оставит файлы как есть
+    std::string alpha, beta, inner;
+    for (int i = 0; i < 40; ++i) alpha += "alpha ", beta += "beta ", inner += "inner ";
+    v.writeFile("/docs/a.txt", alpha, false);
+    v.writeFile("/docs/b.txt", beta, false);
+    v.writeFile("/docs/reports/q1.txt", inner, false);
 
     v.compress("/docs");
 
@@ -124,9 +150,76 @@ static void test_compress_directory_recursive() {
     assert(bytes[0] == 'C' && bytes[1] == 'M' && bytes[2] == 'P');
 
     v.decompress("/docs");
-    assert(v.readFile("/docs/a.txt") == "alpha");
-    assert(v.readFile("/docs/b.txt") == "beta");
-    assert(v.readFile("/docs/reports/q1.txt") == "inner");
+    assert(v.readFile("/docs/a.txt") == alpha);
+    assert(v.readFile("/docs/b.txt") == beta);
+    assert(v.readFile("/docs/reports/q1.txt") == inner);
+}
+
+static void test_compress_tree_in_parallel() {
+    Vfs v;
+    v.mkdir("/logs");
+    std::size_t plainBytes = 0;
+    for (int d = 0; d < 4; ++d) {
+        const std::string dir = "/logs/day" + std::to_string(d);
+        v.mkdir(dir);
+        for (int i = 0; i < 50; ++i) {
+            std::string text;
+            for (int k = 0; k < 20 + i; ++k) text += "event " + std::to_string(k % 7) + " ok\n";
+            v.createFile(dir + "/f" + std::to_string(i) + ".log");
+            v.writeFile(dir + "/f" + std::to_string(i) + ".log", text, false);
+            plainBytes += text.size();
+        }
+    }
+    // ленивая копия должна сохранить несжатое содержимое
+    v.cp("/logs", "/snap", Vfs::CopyMode::Lazy);
+    auto logs = v.resolve("/logs");
+    assert(logs->fileProps.byteSize == plainBytes);
+
+    v.compress("/logs", CompAlgo::LZW_VAR_ALL, 4);
+    std::size_t packedBytes = 0;
+    for (int d = 0; d < 4; ++d) {
+        auto dir = v.resolve("/logs/day" + std::to_string(d));
+        std::size_t dirBytes = 0;
+        for (int i = 0; i < 50; ++i) {
+            auto f = v.resolve("/logs/day" + std::to_string(d) + "/f" + std::to_string(i) + ".log");
+            assert(isCompressed(f->content));
+            assert(f->fileProps.byteSize == f->content.size());
+            dirBytes += f->content.size();
+        }
+        assert(dir->fileProps.byteSize == dirBytes);
+        packedBytes += dirBytes;
+    }
+    assert(logs->fileProps.byteSize == packedBytes);
+    assert(packedBytes < plainBytes);
+    assert(!isCompressed(v.resolve("/snap/day1/f3.log")->content));
+
+    v.decompress("/logs", 3);
+    assert(logs->fileProps.byteSize == plainBytes);
+    assert(v.readFile("/logs/day2/f10.log") == v.readFile("/snap/day2/f10.log"));
+}
+
+static void test_compress_auto_per_file() {
+    Vfs v;
+    v.mkdir("/mixed");
+    std::string text, noise;
+    for (int i = 0; i < 2000; ++i) text += "line " + std::to_string(i % 13) + " of the log\n";
+    std::mt19937 rng(4);
+    for (int i = 0; i < 20000; ++i) noise.push_back(static_cast<char>(rng()));
+    v.createFile("/mixed/a.log");
+    v.writeFile("/mixed/a.log", text, false);
+    v.createFile("/mixed/b.bin");
+    v.writeFile("/mixed/b.bin", noise, false);
+
+    v.compress("/mixed", CompAlgo::AUTO);
+    const auto& log = v.resolve("/mixed/a.log")->content;
+    const auto& bin = v.resolve("/mixed/b.bin")->content;
+    assert(isCompressed(log) && log.size() < text.size() / 4);
+    // шум даже в STORED вырос бы на заголовок — файл остаётся как был
+    assert(!isCompressed(bin) && bin.size() == noise.size());
+
+    v.decompress("/mixed");
+    assert(v.readFile("/mixed/a.log") == text);
+    assert(v.readFile("/mixed/b.bin") == noise);
 }
 
 static void test_decompress_skips_plain_files() {
@@ -171,10 +264,213 @@ static void test_file_properties_tracking() {
     assert(node->fileProps.createdAt == created);
 }
 
+static void test_incremental_utf8_stats() {
+    Vfs v;
+    v.mkdir("/var");
+    v.createFile("/var/log.txt");
+    v.writeFile("/var/log.txt", "Привет", false);
+    auto node = v.resolve("/var/log.txt");
+    // по умолчанию charCount — байты
+    assert(node->fileProps.byteSize == 12);
+    assert(node->fileProps.charCount == 12);
+    v.writeFile("/var/log.txt", "ё", true);
+    assert(node->fileProps.charCount == 14);
+    v.writeFile("/var/log.txt", "Привет", false);
+
+    // подсчёт кодовых точек включается явно и пересчитывает дерево
+    v.setCountCodePoints(true);
+    assert(node->fileProps.charCount == 6);
+    assert(v.resolve("/var")->fileProps.charCount == 6);
+
+    // многобайтовый символ, разрезанный между двумя дозаписями
+    const std::string yo = "ё";
+    v.writeFile("/var/log.txt", yo.substr(0, 1), true);
+    v.writeFile("/var/log.txt", yo.substr(1), true);
+    assert(node->fileProps.byteSize == 14);
+    assert(node->fileProps.charCount == 7);
+
+    std::string big;
+    for (int i = 0; i < 1000; ++i) big += "abcЖ";
+    v.writeFile("/var/log.txt", big, true);
+    assert(node->fileProps.byteSize == 14 + big.size());
+    assert(node->fileProps.charCount == 7 + 4000);
+
+    v.refreshNodeStats(node);
+    assert(node->fileProps.charCount == 7 + 4000);
+    auto text = v.readFile("/var/log.txt");
+    assert(Utf8::countCodePoints(reinterpret_cast<const std::uint8_t*>(text.data()), text.size()) == 4007);
+
+    v.setCountCodePoints(false);
+    assert(node->fileProps.charCount == text.size());
+    assert(v.resolve("/")->fileProps.charCount == text.size());
+}
+
+static void test_transparent_compression_policy() {
+    Vfs v;
+    v.mkdir("/logs");
+    v.mkdir("/logs/raw");
+    CompressionPolicy policy;
+    policy.enabled = true;
+    policy.algo = CompAlgo::LZ_FAST;
+    v.setCompressionPolicy("/logs", policy);
+    // подкаталог может отменить политику предка
+    v.setCompressionPolicy("/logs/raw", CompressionPolicy{});
+    assert(!v.compressionPolicy("/") && v.compressionPolicy("/logs")->enabled);
+
+    std::string line;
+    for (int i = 0; i < 100; ++i) line += "GET /index.html 200\n";
+    v.createFile("/logs/a.log");
+    v.writeFile("/logs/a.log", line, false);
+    auto a = v.resolve("/logs/a.log");
+    assert(isCompressed(a->content));
+    assert(a->fileProps.byteSize == a->content.size() && a->content.size() < line.size());
+    assert(v.readFile("/logs/a.log") == line);
+
+    // дозапись идёт в распакованное содержимое и сжимается снова
+    v.writeFile("/logs/a.log", "tail\n", true);
+    assert(isCompressed(a->content));
+    assert(v.readFile("/logs/a.log") == line + "tail\n");
+
+    v.createFile("/logs/raw/b.log");
+    v.writeFile("/logs/raw/b.log", line, false);
+    assert(!isCompressed(v.resolve("/logs/raw/b.log")->content));
+    // короткий файл сжатие только увеличило бы
+    v.createFile("/logs/tiny");
+    v.writeFile("/logs/tiny", "ok", false);
+    assert(!isCompressed(v.resolve("/logs/tiny")->content));
+
+    // снятие собственной политики возвращает наследование
+    v.setCompressionPolicy("/logs/raw", std::nullopt);
+    assert(v.effectivePolicy(v.resolve("/logs/raw")) != nullptr);
+    expectThrows(ErrorCode::InvalidArg, [&]{ v.setCompressionPolicy("/logs/a.log", policy); });
+    CompressionPolicy noDict = policy;
+    noDict.algo = CompAlgo::LZ_DICT;
+    expectThrows(ErrorCode::InvalidArg, [&]{ v.setCompressionPolicy("/logs", noDict); });
+}
+
+static void test_policy_retries_compression_after_growth() {
+    Vfs v;
+    v.mkdir("/logs");
+    CompressionPolicy policy;
+    policy.enabled = true;
+    policy.algo = CompAlgo::LZ_FAST;
+    v.setCompressionPolicy("/logs", policy);
+    v.createFile("/logs/a.log");
+    v.writeFile("/logs/a.log", "short", false);
+    auto f = v.resolve("/logs/a.log");
+    // сжатие не помогло — следующая попытка только после роста на блок
+    assert(!isCompressed(f->content) && f->compressRetrySize == 5 + kCompressBlock);
+
+    std::string expected = "short";
+    const std::string line = "GET /index.html 200\n";
+    while (expected.size() + line.size() < f->compressRetrySize) {
+        v.writeFile("/logs/a.log", line, true);
+        expected += line;
+        assert(!isCompressed(f->content));
+    }
+    v.writeFile("/logs/a.log", line, true);
+    expected += line;
+    assert(isCompressed(f->content) && v.readFile("/logs/a.log") == expected);
+
+    // перезапись целиком сбрасывает порог
+    v.writeFile("/logs/a.log", "x", false);
+    v.writeFile("/logs/a.log", std::string(4096, 'y'), false);
+    assert(isCompressed(f->content));
+}
+
+static std::string captureCout(const std::function<void()>& fn) {
+    std::ostringstream out;
+    auto* old = std::cout.rdbuf(out.rdbuf());
+    fn();
+    std::cout.rdbuf(old);
+    return out.str();
+}
+
+static void test_commands_read_policy_files_decompressed() {
+    Vfs v;
+    v.mkdir("/logs");
+    CompressionPolicy policy;
+    policy.enabled = true;
+    policy.algo = CompAlgo::LZ_HUFF;
+    v.setCompressionPolicy("/logs", policy);
+    std::string text;
+    for (int i = 0; i < 200; ++i) text += "GET /a 200\n";
+    v.createFile("/logs/a.log");
+    v.writeFile("/logs/a.log", text, false);
+    assert(isCompressed(v.resolve("/logs/a.log")->content));
+
+    assert(captureCout([&] { FileCommands::cat(v, {"/logs/a.log"}); }) == text);
+    // 'G' 'E' 'T' — первые байты текста, а не заголовок CMP
+    assert(captureCout([&] { FileCommands::read(v, {"/logs/a.log", "0", "3"}); }) == "0x47 0x45 0x54 \n");
+
+    FileCommands::echoAppend(v, {"done", ">>", "/logs/a.log"});
+    assert(isCompressed(v.resolve("/logs/a.log")->content));
+    assert(captureCout([&] { FileCommands::cat(v, {"/logs/a.log"}); }) == text + "done");
+    expectThrows(ErrorCode::PathError, [&] { FileCommands::echoAppend(v, {"x", ">>", "/logs/none"}); });
+}
+
+static void test_compressed_append_spans_blocks() {
+    Vfs v;
+    v.mkdir("/logs");
+    CompressionPolicy policy;
+    policy.enabled = true;
+    policy.algo = CompAlgo::LZ_FAST;
+    v.setCompressionPolicy("/logs", policy);
+    v.createFile("/logs/big.log");
+    std::string expected;
+    // дозаписи пересекают границу блока kCompressBlock
+    for (int i = 0; expected.size() < kCompressBlock + kCompressBlock / 2; ++i) {
+        std::string chunk;
+        for (int j = 0; j < 300; ++j) chunk += "req " + std::to_string((i * 300 + j) % 977) + " ok\n";
+        v.writeFile("/logs/big.log", chunk, true);
+        expected += chunk;
+    }
+    auto f = v.resolve("/logs/big.log");
+    assert(isCompressed(f->content));
+    assert(f->fileProps.byteSize == f->content.size());
+    assert(v.readFile("/logs/big.log") == expected);
+    // результат тот же, что и сжатие файла целиком
+    FileContent whole;
+    whole.assignText(expected);
+    compressInplace(whole, CompAlgo::LZ_FAST);
+    assert(whole.bytes() == f->content.bytes());
+}
+
+static void test_decompress_cache_hits() {
+    Vfs v;
+    std::string text;
+    for (int i = 0; i < 2000; ++i) text += "line " + std::to_string(i % 50) + "\n";
+    v.createFile("/hot.txt");
+    v.writeFile("/hot.txt", text, false);
+    v.compress("/hot.txt");
+    for (int i = 0; i < 5; ++i) assert(v.readFile("/hot.txt") == text);
+    auto st = v.cacheStats();
+    assert(st.misses == 1 && st.hits == 4 && st.entries == 1 && st.bytes == text.size());
+
+    // запись сбрасывает запись кэша
+    const std::string fresh(200, 'n');
+    v.writeFile("/hot.txt", fresh, false);
+    assert(v.readFile("/hot.txt") == fresh);
+    v.compress("/hot.txt");
+    assert(v.readFile("/hot.txt") == fresh);
+    assert(v.cacheStats().misses == 2);
+
+    // ёмкость меньше файла — файл не кэшируется, старое вытесняется
+    v.writeFile("/hot.txt", text, false);
+    v.compress("/hot.txt");
+    v.setCacheCapacity(text.size() / 2);
+    assert(v.cacheStats().entries == 0);
+    assert(v.readFile("/hot.txt") == text);
+    assert(v.readFile("/hot.txt") == text);
+    st = v.cacheStats();
+    assert(st.entries == 0 && st.hits == 4);
+}
+
 int main() {
     try {
         test_compression_roundtrip();
         test_empty_compression();
+        test_compress_keeps_tiny_files();
         test_append_and_read_offset();
         test_truncate_and_overwrite();
         test_binary_read_write();
@@ -184,9 +480,17 @@ int main() {
         test_compress_long_runs();
         test_resolve_relative_paths();
         test_compress_directory_recursive();
+        test_compress_tree_in_parallel();
+        test_compress_auto_per_file();
         test_decompress_skips_plain_files();
         test_compress_decompress_errors();
         test_file_properties_tracking();
+        test_incremental_utf8_stats();
+        test_transparent_compression_policy();
+        test_compressed_append_spans_blocks();
+        test_commands_read_policy_files_decompressed();
+        test_policy_retries_compression_after_growth();
+        test_decompress_cache_hits();
         std::cout << "All tests passed!\n";
     } catch (const VfsException& ex) {
         handleException(ex);